@@ -30,7 +30,8 @@
 //
 // 	Our implementation at this point has the following restrictions:
 //
-//	   there is no synchronization for concurrent accesses
+//	   there is no synchronization for concurrent accesses to a
+//	   file, only to the directory and bitmap
 //	   files have a fixed size, set when the file is created
 //	   files cannot be bigger than about 3KB in size
 //	   there is no hierarchical directory structure, and only a limited
@@ -51,6 +52,9 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "synch.h"
+#include "main.h"
+#include "pagecache.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known 
@@ -83,7 +87,7 @@ FileSystem::FileSystem(bool format)
     DEBUG(dbgFile, "Initializing the file system.");
     if (format) {
         PersistentBitmap *freeMap = new PersistentBitmap(NumSectors);
-        Directory *directory = new Directory(NumDirEntries);
+        directory = new Directory(NumDirEntries);
 	FileHeader *mapHdr = new FileHeader;
 	FileHeader *dirHdr = new FileHeader;
 
@@ -130,7 +134,6 @@ FileSystem::FileSystem(bool format)
 	    directory->Print();
         }
         delete freeMap; 
-	delete directory; 
 	delete mapHdr; 
 	delete dirHdr;
     } else {
@@ -138,7 +141,26 @@ FileSystem::FileSystem(bool format)
     // the bitmap and directory; these are left open while Nachos is running
         freeMapFile = new OpenFile(FreeMapSector);
         directoryFile = new OpenFile(DirectorySector);
+        directory = new Directory(NumDirEntries);
+        directory->FetchFrom(directoryFile);
     }
+    dirLock = new RWLock("file system");
+    dirSeq = new SeqLock("root directory");
+}
+
+//----------------------------------------------------------------------
+// FileSystem::~FileSystem
+// 	Close the bitmap and directory files, and free the in-memory
+//	copy of the directory.
+//----------------------------------------------------------------------
+
+FileSystem::~FileSystem()
+{
+    delete dirSeq;
+    delete dirLock;
+    delete directory;
+    delete directoryFile;
+    delete freeMapFile;
 }
 
 //----------------------------------------------------------------------
@@ -163,8 +185,9 @@ FileSystem::FileSystem(bool format)
 //	 	no free entry for file in directory
 //	 	no free space for data blocks for the file 
 //
-// 	Note that this implementation assumes there is no concurrent access
-//	to the file system!
+// 	Create and Remove exclude each other, List and Print, through
+//	the write side of "dirLock"; Open only waits out the in-memory
+//	directory update, through "dirSeq".
 //
 //	"name" -- name of file to be created
 //	"initialSize" -- size of file to be created
@@ -173,7 +196,6 @@ FileSystem::FileSystem(bool format)
 bool
 FileSystem::Create(char *name, int initialSize)
 {
-    Directory *directory;
     PersistentBitmap *freeMap;
     FileHeader *hdr;
     int sector;
@@ -181,9 +203,7 @@ FileSystem::Create(char *name, int initialSize)
 
     DEBUG(dbgFile, "Creating file " << name << " size " << initialSize);
 
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
-
+    dirLock->AcquireWrite();
     if (directory->Find(name) != -1)
       success = FALSE;			// file is already in directory
     else {	
@@ -191,24 +211,28 @@ FileSystem::Create(char *name, int initialSize)
         sector = freeMap->FindAndSet();	// find a sector to hold the file header
     	if (sector == -1) 		
             success = FALSE;		// no free block for file header 
-        else if (!directory->Add(name, sector))
-            success = FALSE;	// no space in directory
 	else {
     	    hdr = new FileHeader;
 	    if (!hdr->Allocate(freeMap, initialSize))
             	success = FALSE;	// no space on disk for data
-	    else {	
-	    	success = TRUE;
-		// everthing worked, flush all changes back to disk
-    	    	hdr->WriteBack(sector); 		
-    	    	directory->WriteBack(directoryFile);
-    	    	freeMap->WriteBack(freeMapFile);
+	    else {
+		// add the name last, so a failure leaves the
+		// directory untouched
+		dirSeq->WriteBegin();
+		success = directory->Add(name, sector);
+		dirSeq->WriteEnd();
+		if (success) {
+		    // everthing worked, flush all changes back to disk
+    	    	    hdr->WriteBack(sector); 		
+    	    	    directory->WriteBack(directoryFile);
+    	    	    freeMap->WriteBack(freeMapFile);
+		}			// else no space in directory
 	    }
             delete hdr;
 	}
         delete freeMap;
     }
-    delete directory;
+    dirLock->ReleaseWrite();
     return success;
 }
 
@@ -219,22 +243,26 @@ FileSystem::Create(char *name, int initialSize)
 //	  Find the location of the file's header, using the directory 
 //	  Bring the header into memory
 //
+//	The lookup is optimistic: it never blocks Create or Remove, and
+//	is simply repeated if one of them changed the directory under it.
+//
 //	"name" -- the text name of the file to be opened
 //----------------------------------------------------------------------
 
 OpenFile *
 FileSystem::Open(char *name)
 { 
-    Directory *directory = new Directory(NumDirEntries);
     OpenFile *openFile = NULL;
+    unsigned int seq;
     int sector;
 
     DEBUG(dbgFile, "Opening file" << name);
-    directory->FetchFrom(directoryFile);
-    sector = directory->Find(name); 
+    do {
+	seq = dirSeq->ReadBegin();
+	sector = directory->Find(name); 
+    } while (dirSeq->ReadRetry(seq));
     if (sector >= 0) 		
 	openFile = new OpenFile(sector);	// name was found in directory 
-    delete directory;
     return openFile;				// return NULL if not found
 }
 
@@ -255,18 +283,20 @@ FileSystem::Open(char *name)
 bool
 FileSystem::Remove(char *name)
 { 
-    Directory *directory;
     PersistentBitmap *freeMap;
     FileHeader *fileHdr;
     int sector;
     
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
+    dirLock->AcquireWrite();
     sector = directory->Find(name);
     if (sector == -1) {
-       delete directory;
+       dirLock->ReleaseWrite();
        return FALSE;			 // file not found 
     }
+    dirSeq->WriteBegin();
+    directory->Remove(name);
+    dirSeq->WriteEnd();
+
     fileHdr = new FileHeader;
     fileHdr->FetchFrom(sector);
 
@@ -274,12 +304,12 @@ FileSystem::Remove(char *name)
 
     fileHdr->Deallocate(freeMap);  		// remove data blocks
     freeMap->Clear(sector);			// remove header block
-    directory->Remove(name);
+    kernel->pageCache->Invalidate(sector);	// the sector may be reused
 
     freeMap->WriteBack(freeMapFile);		// flush to disk
     directory->WriteBack(directoryFile);        // flush to disk
+    dirLock->ReleaseWrite();
     delete fileHdr;
-    delete directory;
     delete freeMap;
     return TRUE;
 } 
@@ -292,11 +322,9 @@ FileSystem::Remove(char *name)
 void
 FileSystem::List()
 {
-    Directory *directory = new Directory(NumDirEntries);
-
-    directory->FetchFrom(directoryFile);
+    dirLock->AcquireRead();
     directory->List();
-    delete directory;
+    dirLock->ReleaseRead();
 }
 
 //----------------------------------------------------------------------
@@ -314,8 +342,10 @@ FileSystem::Print()
 {
     FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
-    PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile,NumSectors);
-    Directory *directory = new Directory(NumDirEntries);
+    PersistentBitmap *freeMap;
+
+    dirLock->AcquireRead();
+    freeMap = new PersistentBitmap(freeMapFile,NumSectors);
 
     printf("Bit map file header:\n");
     bitHdr->FetchFrom(FreeMapSector);
@@ -327,13 +357,12 @@ FileSystem::Print()
 
     freeMap->Print();
 
-    directory->FetchFrom(directoryFile);
     directory->Print();
+    dirLock->ReleaseRead();
 
     delete bitHdr;
     delete dirHdr;
     delete freeMap;
-    delete directory;
 } 
 
 #endif // FILESYS_STUB
@@ -65,10 +65,12 @@ class FileSystem {
 
   
 //  The OpenAFile function is used for kernel open system call
+//  Ids 0 and 1 are never handed out: they name the console
+//  (SysConsoleInput, SysConsoleOutput, see syscall.h).
     OpenFileId OpenAFile(char *name) {
 		OpenFile *openFile = Open(name);
 		if (openFile == NULL) return -1;
-		for (int i = 0; i < 20; i++) {
+		for (int i = 2; i < 20; i++) {
 			if (OpenFileTable[i] == NULL) {
 				OpenFileTable[i] = openFile;
 				return i;
@@ -78,6 +80,7 @@ class FileSystem {
 	}
 
     int WriteFile(char *buffer, int size, OpenFileId id) {
+		if (id < 2 || id >= 20) return -1;	// not a file
    		OpenFile *openFile = OpenFileTable[id];
 		if(openFile == NULL) return -1;
 		int numBytes = openFile->Write(buffer, size);
@@ -85,6 +88,7 @@ class FileSystem {
 	}
 
     int ReadFile(char *buffer, int size, OpenFileId id) {
+		if (id < 2 || id >= 20) return -1;	// not a file
     	OpenFile *openFile = OpenFileTable[id];
 		if(openFile == NULL) return -1;
 		int numBytes = openFile->Read(buffer, size);
@@ -92,6 +96,7 @@ class FileSystem {
 	}
 
     int CloseFile(OpenFileId id) {
+		if (id < 2 || id >= 20) return -1;	// not a file
     	if (OpenFileTable[id] == NULL) return -1;
 		else {
 			delete OpenFileTable[id];
@@ -107,6 +112,10 @@ class FileSystem {
 
 
 #else // FILESYS
+class Directory;
+class RWLock;
+class SeqLock;
+
 class FileSystem {
   public:
     FileSystem(bool format);		// Initialize the file system.
@@ -115,6 +124,7 @@ class FileSystem {
     					// If "format", there is nothing on
 					// the disk, so initialize the directory
     					// and the bitmap of free blocks.
+    ~FileSystem();			// Release the in-memory state
 
     bool Create(char *name, int initialSize);  	
 					// Create a file (UNIX creat)
@@ -132,6 +142,13 @@ class FileSystem {
 					// represented as a file
    OpenFile* directoryFile;		// "Root" directory -- list of 
 					// file names, represented as a file
+   Directory* directory;		// In-memory copy of the root
+					// directory, kept in step with
+					// directoryFile
+   RWLock* dirLock;			// Create/Remove write, List/Print
+					// read; serializes the free map too
+   SeqLock* dirSeq;			// lets Open look names up in
+					// "directory" without blocking
 };
 
 #endif // FILESYS
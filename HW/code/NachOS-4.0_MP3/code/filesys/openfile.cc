@@ -17,6 +17,7 @@
 #include "filehdr.h"
 #include "openfile.h"
 #include "synchdisk.h"
+#include "pagecache.h"
 
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
@@ -28,6 +29,7 @@
 
 OpenFile::OpenFile(int sector)
 { 
+    this->sector = sector;
     hdr = new FileHeader;
     hdr->FetchFrom(sector);
     seekPosition = 0;
@@ -154,6 +156,7 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     if ((position + numBytes) > fileLength)
 	numBytes = fileLength - position;
     DEBUG(dbgFile, "Writing " << numBytes << " bytes at " << position << " from file of length " << fileLength);
+    kernel->pageCache->Invalidate(sector);	// in case it is a program
 
     firstSector = divRoundDown(position, SectorSize);
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
@@ -53,6 +53,8 @@ class OpenFile {
 		}
 
     int Length() { Lseek(file, 0, 2); return Tell(file); }
+    int HeaderSector() { return FileId(file); }	// names the file (the
+					// UNIX inode stands in for the sector)
     
   
   private:
@@ -87,8 +89,11 @@ class OpenFile {
 					// file (this interface is simpler 
 					// than the UNIX idiom -- lseek to 
 					// end of file, tell, lseek back 
+    int HeaderSector() { return sector; }	// Names the file, for as
+					// long as it exists
     
   private:
+    int sector;				// Where the header is on disk
     FileHeader *hdr;			// Header for this file 
     int seekPosition;			// Current position within the file
 };
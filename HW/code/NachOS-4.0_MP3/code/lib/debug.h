@@ -31,6 +31,7 @@ const char dbgNet = 'n';    // network emulation
 const char dbgSys = 'u';    // systemcall
 const char dbgTraCode = 'c';
 const char dbgZ = 'z'; // scheduling
+const char dbgProfile = 'p'; // paging profile of each address space
 
 class Debug {
 public:
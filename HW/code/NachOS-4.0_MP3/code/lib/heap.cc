@@ -0,0 +1,160 @@
+// heap.cc
+//     	Routines to manage a binary min-heap of "things".
+//	The heap is a complete binary tree stored level by level in an
+//	array, in which no item is smaller than its parent; so the
+//	smallest item is always at the root, items[0].
+//
+//	The array starts small and doubles whenever it fills up.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+const int HeapInitialSize = 16;
+
+//----------------------------------------------------------------------
+// Heap<T>::Heap
+//	Initialize a heap, empty to start with.
+//
+//	"comp" is the function used to order the items.
+//----------------------------------------------------------------------
+
+template <class T> Heap<T>::Heap(int (*comp)(T x, T y)) {
+  size = HeapInitialSize;
+  items = new T[size];
+  numInHeap = 0;
+  compare = comp;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::~Heap
+//	Prepare a heap for deallocation.  Frees the array, but not the
+//	data the items point to.
+//----------------------------------------------------------------------
+
+template <class T> Heap<T>::~Heap() { delete[] items; }
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftUp, Heap<T>::SiftDown
+//	Restore the heap order after the item at "i" got smaller
+//	(moving it towards the root) or larger (towards the leaves).
+//----------------------------------------------------------------------
+
+template <class T> void Heap<T>::SiftUp(int i) {
+  T item = items[i];
+
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (compare(item, items[parent]) >= 0) {
+      break;
+    }
+    items[i] = items[parent];
+    i = parent;
+  }
+  items[i] = item;
+}
+
+template <class T> void Heap<T>::SiftDown(int i) {
+  T item = items[i];
+
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= numInHeap) {
+      break;
+    }
+    if (child + 1 < numInHeap &&
+        compare(items[child + 1], items[child]) < 0) {
+      child++; // the smaller child
+    }
+    if (compare(items[child], item) >= 0) {
+      break;
+    }
+    items[i] = items[child];
+    i = child;
+  }
+  items[i] = item;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Insert
+//	Put an item into the heap, growing the array if it is full.
+//
+//	"item" is the thing to put in the heap.
+//----------------------------------------------------------------------
+
+template <class T> void Heap<T>::Insert(T item) {
+  if (numInHeap == size) {
+    T *bigger = new T[2 * size];
+    for (int i = 0; i < numInHeap; i++) {
+      bigger[i] = items[i];
+    }
+    delete[] items;
+    items = bigger;
+    size *= 2;
+  }
+  items[numInHeap] = item;
+  SiftUp(numInHeap++);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::RemoveMin
+//	Remove the smallest item from the heap, and return it.
+//	The heap must not be empty.
+//----------------------------------------------------------------------
+
+template <class T> T Heap<T>::RemoveMin() {
+  T min;
+
+  ASSERT(!IsEmpty());
+  min = items[0];
+  items[0] = items[--numInHeap];
+  if (numInHeap > 0) {
+    SiftDown(0);
+  }
+  return min;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SanityCheck
+//	Check that no item is smaller than its parent.
+//----------------------------------------------------------------------
+
+template <class T> void Heap<T>::SanityCheck() const {
+  ASSERT(numInHeap >= 0 && numInHeap <= size);
+  for (int i = 1; i < numInHeap; i++) {
+    ASSERT(compare(items[(i - 1) / 2], items[i]) <= 0);
+  }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SelfTest
+//	Test whether this module is working.
+//----------------------------------------------------------------------
+
+template <class T> void Heap<T>::SelfTest(T *p, int numEntries) {
+  int i;
+  T *q = new T[numEntries];
+
+  ASSERT(IsEmpty());
+  for (i = 0; i < numEntries; i++) {
+    Insert(p[i]);
+    SanityCheck();
+  }
+  ASSERT(NumInHeap() == numEntries);
+
+  // should be able to get out everything we put in, in order
+  for (i = 0; i < numEntries; i++) {
+    q[i] = RemoveMin();
+    SanityCheck();
+  }
+  ASSERT(IsEmpty());
+  for (i = 0; i < (numEntries - 1); i++) {
+    ASSERT(compare(q[i], q[i + 1]) <= 0);
+  }
+
+  delete[] q;
+}
@@ -0,0 +1,61 @@
+// heap.h
+//	Data structures to manage a binary min-heap -- a priority queue
+//	kept in an array, used where only the smallest item is ever
+//	needed (insert and remove-minimum are O(log n), find-minimum
+//	is O(1)).
+//
+//	As with lists, the heap can hold any kind of item; allocation
+//	and deallocation of the items themselves is up to the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines a min-heap, kept in the order given by
+// a "Compare" function, with the same conventions as for SortedList:
+//	   int Compare(T x, T y)
+//		returns -1 if x < y
+//		returns 0 if x == y
+//		returns 1 if x > y
+//
+// Items that compare equal come out in no particular order; break
+// ties in the compare function if that matters.
+
+template <class T> class Heap {
+public:
+  Heap(int (*comp)(T x, T y)); // initialize an empty heap
+  ~Heap();                     // de-allocate the heap
+
+  void Insert(T item); // put an item into the heap
+
+  T Min() { return items[0]; } // smallest item, not removed
+  T RemoveMin();               // take the smallest item out
+
+  int NumInHeap() { return numInHeap; }
+  bool IsEmpty() { return (numInHeap == 0); }
+
+  void SanityCheck() const; // has this heap been corrupted?
+  void SelfTest(T *p, int numEntries);
+  // verify module is working
+
+private:
+  T *items;      // items[0] is the smallest; the children
+                 // of items[i] are items[2i+1] and items[2i+2]
+  int numInHeap; // number of items in the heap
+  int size;      // number of slots in "items"
+  int (*compare)(T x, T y);
+
+  void SiftUp(int i);
+  void SiftDown(int i);
+};
+
+#include "heap.cc" // templates are really like macros
+                   // so needs to be included in every
+                   // file that uses the template
+#endif // HEAP_H
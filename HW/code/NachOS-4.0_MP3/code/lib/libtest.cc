@@ -1,6 +1,7 @@
 // libtest.cc 
 //	Driver code to call self-test routines for standard library
-//	classes -- bitmaps, lists, sorted lists, and hash tables.
+//	classes -- bitmaps, lists, sorted lists, hash tables,
+//	red-black trees and heaps.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -11,6 +12,8 @@
 #include "bitmap.h"
 #include "list.h"
 #include "hash.h"
+#include "rbtree.h"
+#include "heap.h"
 #include "sysdep.h"
 
 //----------------------------------------------------------------------
@@ -53,6 +56,15 @@ HashKey(char *str) {
 // Array of values to be inserted into a List or SortedList. 
 static int listTestVector[] = { 9, 5, 7 };
 
+// Array of distinct values to be inserted into a RBTree.
+// Enough to exercise the rotations on both sides.
+static int treeTestVector[] = { 41, 38, 31, 12, 19, 8, 45, 50, 47, 3, 60, 27 };
+
+// Array of values to be inserted into a Heap.  There are enough
+// here to make it grow, and some of them are equal.
+static int heapTestVector[] = { 17, 4, 23, 8, 4, 42, 15, 16, 1, 99, 23,
+	 7, 30, 2, 11, 5, 64, 8, 0, 33 };
+
 // Array of values to be inserted into the HashTable
 // There are enough here to force a ReHash().
 static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
@@ -71,15 +83,21 @@ LibSelfTest () {
     SortedList<int> *sortList = new SortedList<int>(IntCompare);
     HashTable<int, char *> *hashTable = 
 	new HashTable<int, char *>(HashKey, HashInt);
+    RBTree<int> *tree = new RBTree<int>(IntCompare);
+    Heap<int> *heap = new Heap<int>(IntCompare);
 	
 		
     map->SelfTest();
     list->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     sortList->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     hashTable->SelfTest(hashTestVector, sizeof(hashTestVector)/sizeof(char *));
+    tree->SelfTest(treeTestVector, sizeof(treeTestVector)/sizeof(int));
+    heap->SelfTest(heapTestVector, sizeof(heapTestVector)/sizeof(int));
 
     delete map;
     delete list;
     delete sortList;
     delete hashTable;
+    delete tree;
+    delete heap;
 }
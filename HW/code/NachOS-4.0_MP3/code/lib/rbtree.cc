@@ -0,0 +1,515 @@
+// rbtree.cc
+//     	Routines to manage a red-black tree of "things".
+//	The tree is a binary search tree in which every node is
+//	colored red or black, such that
+//		the root is black,
+//		a red node has no red child, and
+//		every path from a node down to a leaf passes through
+//		the same number of black nodes.
+//	This keeps the depth within 2*log(n+1), so Insert, Remove
+//	and RemoveMin are all O(log n).  The smallest node is cached
+//	so that Min is O(1).
+//
+//	Missing children are NULL (there is no sentinel node); NULL
+//	counts as black.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+//----------------------------------------------------------------------
+// RBNode<T>::RBNode
+// 	Initialize a tree node.  New nodes start out red.
+//
+//	"itm" is the thing to be put in the tree.
+//----------------------------------------------------------------------
+
+template <class T> RBNode<T>::RBNode(T itm) {
+  item = itm;
+  left = right = parent = NULL; // always initialize to something!
+  red = TRUE;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RBTree
+//	Initialize a tree, empty to start with.
+//
+//	"comp" is the function used to order the items.
+//----------------------------------------------------------------------
+
+template <class T> RBTree<T>::RBTree(int (*comp)(T x, T y)) {
+  root = leftmost = NULL;
+  numInTree = 0;
+  compare = comp;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::~RBTree
+//	Prepare a tree for deallocation.  Frees the tree nodes, but
+//	not the data those nodes point to.
+//----------------------------------------------------------------------
+
+template <class T> RBTree<T>::~RBTree() { DeleteNodes(root); }
+
+template <class T> void RBTree<T>::DeleteNodes(RBNode<T> *node) {
+  if (node == NULL) {
+    return;
+  }
+  DeleteNodes(node->left);
+  DeleteNodes(node->right);
+  delete node;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Find
+//	Return the node holding "item", or NULL if it isn't in the tree.
+//----------------------------------------------------------------------
+
+template <class T> RBNode<T> *RBTree<T>::Find(T item) const {
+  RBNode<T> *node = root;
+
+  while (node != NULL) {
+    int c = compare(item, node->item);
+    if (c == 0) {
+      return node;
+    }
+    node = (c < 0) ? node->left : node->right;
+  }
+  return NULL;
+}
+
+template <class T> bool RBTree<T>::IsInTree(T item) const {
+  return Find(item) != NULL;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RotateLeft, RotateRight
+//	Rotate the subtree rooted at "x", preserving the search order.
+//
+//	     x                y
+//	    / \              / \    RotateLeft(x) -->
+//	   a   y    <-->    x   c
+//	      / \          / \      <-- RotateRight(y)
+//	     b   c        a   b
+//----------------------------------------------------------------------
+
+template <class T> void RBTree<T>::RotateLeft(RBNode<T> *x) {
+  RBNode<T> *y = x->right;
+
+  x->right = y->left;
+  if (y->left != NULL) {
+    y->left->parent = x;
+  }
+  y->parent = x->parent;
+  if (x->parent == NULL) {
+    root = y;
+  } else if (x == x->parent->left) {
+    x->parent->left = y;
+  } else {
+    x->parent->right = y;
+  }
+  y->left = x;
+  x->parent = y;
+}
+
+template <class T> void RBTree<T>::RotateRight(RBNode<T> *x) {
+  RBNode<T> *y = x->left;
+
+  x->left = y->right;
+  if (y->right != NULL) {
+    y->right->parent = x;
+  }
+  y->parent = x->parent;
+  if (x->parent == NULL) {
+    root = y;
+  } else if (x == x->parent->right) {
+    x->parent->right = y;
+  } else {
+    x->parent->left = y;
+  }
+  y->right = x;
+  x->parent = y;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Insert
+//      Insert an "item" into the tree, in order.  The item must not
+//	compare equal to anything already in the tree.
+//----------------------------------------------------------------------
+
+template <class T> void RBTree<T>::Insert(T item) {
+  RBNode<T> *z = new RBNode<T>(item);
+  RBNode<T> *parent = NULL;
+  RBNode<T> *node = root;
+  bool isLeftmost = TRUE;
+  int c = 0;
+
+  while (node != NULL) {
+    parent = node;
+    c = compare(item, node->item);
+    ASSERT(c != 0); // no duplicates
+    if (c < 0) {
+      node = node->left;
+    } else {
+      node = node->right;
+      isLeftmost = FALSE;
+    }
+  }
+
+  z->parent = parent;
+  if (parent == NULL) {
+    root = z;
+  } else if (c < 0) {
+    parent->left = z;
+  } else {
+    parent->right = z;
+  }
+  if (isLeftmost) {
+    leftmost = z;
+  }
+  numInTree++;
+
+  InsertFixup(z);
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::InsertFixup
+//	Restore the red-black properties after "z" (red) was linked in.
+//	The only possible violation is a red parent.
+//----------------------------------------------------------------------
+
+template <class T> void RBTree<T>::InsertFixup(RBNode<T> *z) {
+  while (z->parent != NULL && z->parent->red) {
+    RBNode<T> *p = z->parent;
+    RBNode<T> *g = p->parent; // exists, since the root is black
+
+    if (p == g->left) {
+      RBNode<T> *uncle = g->right;
+      if (uncle != NULL && uncle->red) { // recolor and move up
+        p->red = FALSE;
+        uncle->red = FALSE;
+        g->red = TRUE;
+        z = g;
+      } else {
+        if (z == p->right) {
+          z = p;
+          RotateLeft(z);
+          p = z->parent;
+        }
+        p->red = FALSE;
+        g->red = TRUE;
+        RotateRight(g);
+      }
+    } else { // mirror image of the above
+      RBNode<T> *uncle = g->left;
+      if (uncle != NULL && uncle->red) {
+        p->red = FALSE;
+        uncle->red = FALSE;
+        g->red = TRUE;
+        z = g;
+      } else {
+        if (z == p->left) {
+          z = p;
+          RotateRight(z);
+          p = z->parent;
+        }
+        p->red = FALSE;
+        g->red = TRUE;
+        RotateLeft(g);
+      }
+    }
+  }
+  root->red = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Transplant
+//	Replace the subtree rooted at "u" by the one rooted at "v".
+//----------------------------------------------------------------------
+
+template <class T> void RBTree<T>::Transplant(RBNode<T> *u, RBNode<T> *v) {
+  if (u->parent == NULL) {
+    root = v;
+  } else if (u == u->parent->left) {
+    u->parent->left = v;
+  } else {
+    u->parent->right = v;
+  }
+  if (v != NULL) {
+    v->parent = u->parent;
+  }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Remove
+//      Remove "item" from the tree.  Return TRUE if it was found.
+//----------------------------------------------------------------------
+
+template <class T> bool RBTree<T>::Remove(T item) {
+  RBNode<T> *z = Find(item);
+  RBNode<T> *x, *xParent;
+  bool removedRed;
+
+  if (z == NULL) {
+    return FALSE;
+  }
+
+  if (z == leftmost) { // successor becomes the new minimum
+    if (z->right != NULL) {
+      for (leftmost = z->right; leftmost->left != NULL;
+           leftmost = leftmost->left)
+        ;
+    } else {
+      leftmost = z->parent;
+    }
+  }
+
+  removedRed = z->red;
+  if (z->left == NULL) {
+    x = z->right;
+    xParent = z->parent;
+    Transplant(z, z->right);
+  } else if (z->right == NULL) {
+    x = z->left;
+    xParent = z->parent;
+    Transplant(z, z->left);
+  } else { // two children: splice out the successor instead
+    RBNode<T> *y = z->right;
+    while (y->left != NULL) {
+      y = y->left;
+    }
+    removedRed = y->red;
+    x = y->right;
+    if (y->parent == z) {
+      xParent = y;
+    } else {
+      xParent = y->parent;
+      Transplant(y, y->right);
+      y->right = z->right;
+      y->right->parent = y;
+    }
+    Transplant(z, y);
+    y->left = z->left;
+    y->left->parent = y;
+    y->red = z->red;
+  }
+  delete z;
+  numInTree--;
+
+  if (!removedRed) {
+    RemoveFixup(x, xParent);
+  }
+  return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RemoveFixup
+//	Restore the red-black properties after a black node was taken
+//	out from above "x".  "x" may be NULL, so its parent is passed
+//	separately.
+//----------------------------------------------------------------------
+
+template <class T>
+void RBTree<T>::RemoveFixup(RBNode<T> *x, RBNode<T> *xParent) {
+  while (x != root && (x == NULL || !x->red)) {
+    if (x == xParent->left) {
+      RBNode<T> *w = xParent->right; // non-NULL: x's side is short
+      if (w->red) {
+        w->red = FALSE;
+        xParent->red = TRUE;
+        RotateLeft(xParent);
+        w = xParent->right;
+      }
+      if ((w->left == NULL || !w->left->red) &&
+          (w->right == NULL || !w->right->red)) {
+        w->red = TRUE;
+        x = xParent;
+        xParent = x->parent;
+      } else {
+        if (w->right == NULL || !w->right->red) {
+          w->left->red = FALSE;
+          w->red = TRUE;
+          RotateRight(w);
+          w = xParent->right;
+        }
+        w->red = xParent->red;
+        xParent->red = FALSE;
+        w->right->red = FALSE;
+        RotateLeft(xParent);
+        x = root;
+      }
+    } else { // mirror image of the above
+      RBNode<T> *w = xParent->left;
+      if (w->red) {
+        w->red = FALSE;
+        xParent->red = TRUE;
+        RotateRight(xParent);
+        w = xParent->left;
+      }
+      if ((w->left == NULL || !w->left->red) &&
+          (w->right == NULL || !w->right->red)) {
+        w->red = TRUE;
+        x = xParent;
+        xParent = x->parent;
+      } else {
+        if (w->left == NULL || !w->left->red) {
+          w->right->red = FALSE;
+          w->red = TRUE;
+          RotateLeft(w);
+          w = xParent->left;
+        }
+        w->red = xParent->red;
+        xParent->red = FALSE;
+        w->left->red = FALSE;
+        RotateRight(xParent);
+        x = root;
+      }
+    }
+  }
+  if (x != NULL) {
+    x->red = FALSE;
+  }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RemoveMin
+//      Remove the smallest item from the tree, and return it.
+//	The tree must not be empty.
+//----------------------------------------------------------------------
+
+template <class T> T RBTree<T>::RemoveMin() {
+  T item;
+
+  ASSERT(!IsEmpty());
+  item = leftmost->item;
+  Remove(item);
+  return item;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Apply
+//	Apply function to every item in the tree, in sorted order.
+//
+//	"f" -- the procedure to apply
+//----------------------------------------------------------------------
+
+template <class T> void RBTree<T>::Apply(void (*f)(T)) const {
+  ApplyNode(root, f);
+}
+
+template <class T>
+void RBTree<T>::ApplyNode(RBNode<T> *node, void (*f)(T)) const {
+  if (node == NULL) {
+    return;
+  }
+  ApplyNode(node->left, f);
+  (*f)(node->item);
+  ApplyNode(node->right, f);
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::SanityCheck
+//	Test whether this is still a legal red-black tree: items are
+//	in order, parent links are consistent, no red node has a red
+//	child, every path has the same black height, the count is
+//	right and the cached minimum really is the minimum.
+//----------------------------------------------------------------------
+
+template <class T> void RBTree<T>::SanityCheck() const {
+  int count = 0;
+
+  if (root == NULL) {
+    ASSERT(numInTree == 0);
+    ASSERT(leftmost == NULL);
+    return;
+  }
+  ASSERT(!root->red);
+  ASSERT(root->parent == NULL);
+  CheckNode(root, &count);
+  ASSERT(count == numInTree);
+
+  RBNode<T> *min = root;
+  while (min->left != NULL) {
+    min = min->left;
+  }
+  ASSERT(min == leftmost);
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::CheckNode
+//	Check the subtree rooted at "node"; return its black height and
+//	add its size to "count".
+//----------------------------------------------------------------------
+
+template <class T>
+int RBTree<T>::CheckNode(RBNode<T> *node, int *count) const {
+  int leftHeight, rightHeight;
+
+  if (node == NULL) {
+    return 1;
+  }
+  (*count)++;
+  if (node->left != NULL) {
+    ASSERT(node->left->parent == node);
+    ASSERT(compare(node->left->item, node->item) < 0);
+    ASSERT(!(node->red && node->left->red));
+  }
+  if (node->right != NULL) {
+    ASSERT(node->right->parent == node);
+    ASSERT(compare(node->right->item, node->item) > 0);
+    ASSERT(!(node->red && node->right->red));
+  }
+  leftHeight = CheckNode(node->left, count);
+  rightHeight = CheckNode(node->right, count);
+  ASSERT(leftHeight == rightHeight);
+  return leftHeight + (node->red ? 0 : 1);
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::SelfTest
+//	Test whether this module is working.  The entries must all
+//	be distinct.
+//----------------------------------------------------------------------
+
+template <class T> void RBTree<T>::SelfTest(T *p, int numEntries) {
+  int i;
+  T *q = new T[numEntries];
+
+  ASSERT(IsEmpty());
+  for (i = 0; i < numEntries; i++) {
+    Insert(p[i]);
+    ASSERT(IsInTree(p[i]));
+    SanityCheck();
+  }
+  ASSERT(NumInTree() == numEntries);
+
+  // take out every other entry, then put it back
+  for (i = 0; i < numEntries; i += 2) {
+    bool found = Remove(p[i]);
+
+    ASSERT(found);
+    ASSERT(!IsInTree(p[i]));
+    SanityCheck();
+  }
+  for (i = 0; i < numEntries; i += 2) {
+    Insert(p[i]);
+  }
+  SanityCheck();
+
+  // should be able to get out everything we put in, in order
+  for (i = 0; i < numEntries; i++) {
+    q[i] = RemoveMin();
+    ASSERT(!IsInTree(q[i]));
+  }
+  ASSERT(IsEmpty());
+  for (i = 0; i < (numEntries - 1); i++) {
+    ASSERT(compare(q[i], q[i + 1]) < 0);
+  }
+  SanityCheck();
+
+  delete[] q;
+}
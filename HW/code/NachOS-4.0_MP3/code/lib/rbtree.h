@@ -0,0 +1,86 @@
+// rbtree.h
+//	Data structures to manage a red-black tree -- a balanced binary
+//	search tree, used where a SortedList would be too slow
+//	(insert, remove and find-minimum are all O(log n)).
+//
+//	As with lists, the tree can hold any kind of item; allocation
+//	and deallocation of the items themselves is up to the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines a node in the tree.  Like ListElement,
+// it is private to this module; made public for notational convenience.
+
+template <class T> class RBNode {
+public:
+  RBNode(T itm); // initialize a tree node
+
+  RBNode *left, *right, *parent;
+  bool red; // TRUE if red, FALSE if black
+  T item;   // item in the tree
+};
+
+// The following class defines a red-black tree, kept in the order
+// given by a "Compare" function, with the same conventions as for
+// SortedList:
+//	   int Compare(T x, T y)
+//		returns -1 if x < y
+//		returns 0 if x == y
+//		returns 1 if x > y
+//
+// Items are located by comparison, so no two items in the tree
+// may compare equal.  Break ties in the compare function (for
+// instance, by a thread ID).
+
+template <class T> class RBTree {
+public:
+  RBTree(int (*comp)(T x, T y)); // initialize an empty tree
+  ~RBTree();                     // de-allocate the tree
+
+  void Insert(T item); // put an item into the tree
+  bool Remove(T item); // take an item out of the tree; return
+                       // FALSE if it wasn't there
+
+  T Min() { return leftmost->item; } // smallest item, not removed
+  T RemoveMin();                     // take the smallest item out
+
+  bool IsInTree(T item) const; // is the item in the tree?
+  int NumInTree() { return numInTree; }
+  bool IsEmpty() { return (numInTree == 0); }
+
+  void Apply(void (*f)(T)) const; // apply function to all items,
+                                  // in sorted order
+
+  void SanityCheck() const; // has this tree been corrupted?
+  void SelfTest(T *p, int numEntries);
+  // verify module is working
+
+private:
+  RBNode<T> *root;     // NULL if the tree is empty
+  RBNode<T> *leftmost; // cached smallest node, NULL if empty
+  int numInTree;       // number of items in the tree
+  int (*compare)(T x, T y);
+
+  RBNode<T> *Find(T item) const;
+  void RotateLeft(RBNode<T> *x);
+  void RotateRight(RBNode<T> *x);
+  void InsertFixup(RBNode<T> *z);
+  void RemoveFixup(RBNode<T> *x, RBNode<T> *xParent);
+  void Transplant(RBNode<T> *u, RBNode<T> *v);
+  void ApplyNode(RBNode<T> *node, void (*f)(T)) const;
+  void DeleteNodes(RBNode<T> *node);
+  int CheckNode(RBNode<T> *node, int *count) const;
+};
+
+#include "rbtree.cc" // templates are really like macros
+                     // so needs to be included in every
+                     // file that uses the template
+#endif // RBTREE_H
@@ -32,6 +32,7 @@
 #include <sys/file.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/wait.h>
 #include <cerrno>
 
 #ifdef SOLARIS
@@ -50,6 +51,7 @@
 extern "C" {
 #include <signal.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 
 #ifndef NO_MPROT 
 #include <sys/mman.h>
@@ -171,6 +173,53 @@ Exit(int exitCode)
     exit(exitCode);
 }
 
+//----------------------------------------------------------------------
+// ForkProcess
+// 	Make a copy of the UNIX process running Nachos.  Return 0 in
+//	the copy, and the copy's process id in the original.
+//----------------------------------------------------------------------
+
+int
+ForkProcess()
+{
+    int pid = fork();
+
+    ASSERT(pid >= 0);
+    return pid;
+}
+
+//----------------------------------------------------------------------
+// WaitProcess
+// 	Wait for any copy made by ForkProcess to exit.  Return its
+//	process id, and set "exitCode" to its exit code, or to -1 if it
+//	was killed (e.g., it failed an ASSERT).
+//----------------------------------------------------------------------
+
+int
+WaitProcess(int *exitCode)
+{
+    int status;
+    int pid = wait(&status);
+
+    ASSERT(pid >= 0);
+    *exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    return pid;
+}
+
+//----------------------------------------------------------------------
+// OpenPipe
+// 	Make a UNIX pipe: what is written to fds[1] can be read from
+//	fds[0].  Abort on error.
+//----------------------------------------------------------------------
+
+void
+OpenPipe(int fds[2])
+{
+    int retVal = pipe(fds);
+
+    ASSERT(retVal >= 0);
+}
+
 //----------------------------------------------------------------------
 // RandomInit
 // 	Initialize the pseudo-random number generator.  We use the
@@ -396,6 +445,22 @@ Tell(int fd)
 #endif
 }
 
+//----------------------------------------------------------------------
+// FileId
+// 	Return a number naming the file open on "fd" (its inode), the
+//	same however the file was opened.
+//----------------------------------------------------------------------
+
+int
+FileId(int fd)
+{
+    struct stat st;
+    int retVal = fstat(fd, &st);
+
+    ASSERT(retVal == 0);
+    return (int)st.st_ino;
+}
+
 
 //----------------------------------------------------------------------
 // Close
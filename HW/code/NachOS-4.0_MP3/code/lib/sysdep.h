@@ -25,6 +25,14 @@ extern void Exit(int exitCode);
 extern void Delay(int seconds);
 extern void UDelay(unsigned int usec);// rcgood - to avoid spinners.
 
+// Run copies of Nachos side by side: fork a copy of this process
+// (returns 0 in the copy, the copy's id in the original), wait for any
+// copy to exit, and make a pipe to talk to it (fds[0] reads, fds[1]
+// writes)
+extern int ForkProcess();
+extern int WaitProcess(int *exitCode);	// exitCode -1 if it was killed
+extern void OpenPipe(int fds[2]);
+
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(void (*cleanup)(int));
 
@@ -50,6 +58,7 @@ extern int ReadPartial(int fd, char *buffer, int nBytes);
 extern void WriteFile(int fd, char *buffer, int nBytes);
 extern void Lseek(int fd, int offset, int whence);
 extern int Tell(int fd);
+extern int FileId(int fd);
 extern int Close(int fd);
 extern bool Unlink(char *name);
 
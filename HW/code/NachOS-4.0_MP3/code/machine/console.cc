@@ -34,7 +34,8 @@ ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall)
 
     // set up the stuff to emulate asynchronous interrupts
     callWhenAvail = toCall;
-    incoming = EOF;
+    numIncoming = nextIncoming = 0;
+    atEnd = FALSE;
 
     // start polling for incoming keystrokes
     kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
@@ -57,36 +58,37 @@ ConsoleInput::~ConsoleInput()
 // 	Simulator calls this when a character may be available to be
 //	read in from the simulated keyboard (eg, the user typed something).
 //
-//	First check to make sure character is available.
-//	Then invoke the "callBack" registered by whoever wants the character.
+//	First check to make sure character is available.  Read in all
+//	that are (up to ConsoleReadSize), so that a burst of input, or
+//	an input file, does not cost a poll per character.
+//	Then invoke the "callBack" registered by whoever wants them.
 //----------------------------------------------------------------------
 
 void
 ConsoleInput::CallBack()
 {
-  char c;
   int readCount;
 
-    ASSERT(incoming == EOF);
+    ASSERT(nextIncoming == numIncoming);
     if (!PollFile(readFileNo)) { // nothing to be read
         // schedule the next time to poll for a packet
         kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
     } else { 
-    	// otherwise, try to read a character
-    	readCount = ReadPartial(readFileNo, &c, sizeof(char));
-	if (readCount == 0) {
+    	// otherwise, try to read the characters
+    	readCount = ReadPartial(readFileNo, incoming, ConsoleReadSize);
+	if (readCount <= 0) {
 	   // this seems to happen at end of file, when the
 	   // console input is a regular file
 	   // don't schedule an interrupt, since there will never
 	   // be any more input
-	   // just do nothing....
+	   atEnd = TRUE;
 	}
 	else {
-	  // save the character and notify the OS that
-	  // it is available
-	  ASSERT(readCount == sizeof(char));
-	  incoming = c;
-	  kernel->stats->numConsoleCharsRead++;
+	  // save the characters and notify the OS that
+	  // they are available
+	  numIncoming = readCount;
+	  nextIncoming = 0;
+	  kernel->stats->numConsoleCharsRead += readCount;
 	}
 	callWhenAvail->CallBack();
     }
@@ -101,13 +103,35 @@ ConsoleInput::CallBack()
 char
 ConsoleInput::GetChar()
 {
-   char ch = incoming;
+   char ch;
 
-   if (incoming != EOF) {	// schedule when next char will arrive
+   if (GetBuffer(&ch, 1) <= 0)
+       return EOF;
+   return ch;
+}
+
+//----------------------------------------------------------------------
+// ConsoleInput::GetBuffer()
+// 	Read up to "max" characters from the input buffer into "buf".
+//	Return how many, 0 if none are buffered, or -1 if there will
+//	never be any more.  Once the buffer is empty, schedule when the
+//	next characters will arrive.
+//----------------------------------------------------------------------
+
+int
+ConsoleInput::GetBuffer(char *buf, int max)
+{
+   int n = min(max, numIncoming - nextIncoming);
+
+   if (n <= 0)
+       return atEnd ? -1 : 0;
+   bcopy(&incoming[nextIncoming], buf, n);
+   nextIncoming += n;
+   if (nextIncoming == numIncoming) {	// schedule the next poll
+       numIncoming = nextIncoming = 0;
        kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
    }
-   incoming = EOF;
-   return ch;
+   return n;
 }
 
 
@@ -130,6 +154,7 @@ ConsoleOutput::ConsoleOutput(char *writeFile, CallBackObj *toCall)
 
     callWhenDone = toCall;
     putBusy = FALSE;
+    putCount = 0;
 }
 
 //----------------------------------------------------------------------
@@ -154,7 +179,7 @@ ConsoleOutput::CallBack()
 {
 	DEBUG(dbgTraCode, "In ConsoleOutput::CallBack(), " << kernel->stats->totalTicks);
     putBusy = FALSE;
-    kernel->stats->numConsoleCharsWritten++;
+    kernel->stats->numConsoleCharsWritten += putCount;
     callWhenDone->CallBack();
 }
 
@@ -170,5 +195,37 @@ ConsoleOutput::PutChar(char ch)
     ASSERT(putBusy == FALSE);
     WriteFile(writeFileNo, &ch, sizeof(char));
     putBusy = TRUE;
+    putCount = 1;
     kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
 }
+
+//----------------------------------------------------------------------
+// ConsoleOutput::PutBuffer()
+// 	Write "n" characters to the simulated display with one host
+//	write, and schedule a single interrupt for when the last of
+//	them has gone out (each still takes ConsoleTime).
+//----------------------------------------------------------------------
+
+void
+ConsoleOutput::PutBuffer(char *buf, int n)
+{
+    ASSERT(putBusy == FALSE && n > 0);
+    WriteFile(writeFileNo, buf, n);
+    putBusy = TRUE;
+    putCount = n;
+    kernel->interrupt->Schedule(this, ConsoleTime * n, ConsoleWriteInt);
+}
+
+//----------------------------------------------------------------------
+// ConsoleOutput::Flush()
+// 	Write "n" characters to the display right away, without an
+//	interrupt: the kernel is about to print, or shut down, and
+//	would see it too late.  They are not counted here: at shutdown
+//	the statistics are gone already.
+//----------------------------------------------------------------------
+
+void
+ConsoleOutput::Flush(char *buf, int n)
+{
+    WriteFile(writeFileNo, buf, n);
+}
@@ -44,6 +44,8 @@
 // serial input and serial output.  But conceptually simpler to
 // use two objects.
 
+const int ConsoleReadSize = 64;	// characters read per poll, at most
+
 class ConsoleInput : public CallBackObj {
   public:
     ConsoleInput(char *readFile, CallBackObj *toCall);
@@ -54,6 +56,10 @@ class ConsoleInput : public CallBackObj {
 				// available, return it.  Otherwise, return EOF.
     				// "callWhenAvail" is called whenever there is 
 				// a char to be gotten
+    int GetBuffer(char *buf, int max);
+				// Same, for all the chars that arrived
+				// (up to "max"); return how many, 0 if
+				// none, -1 at end of file
 
     void CallBack();		// Invoked when a character arrives
 				// from the keyboard.
@@ -62,9 +68,11 @@ class ConsoleInput : public CallBackObj {
     int readFileNo;			// UNIX file emulating the keyboard 
     CallBackObj *callWhenAvail;		// Interrupt handler to call when 
 					// there is a char to be read
-    char incoming;    			// Contains the character to be read,
-					// if there is one available. 
-					// Otherwise contains EOF.
+    char incoming[ConsoleReadSize];	// Contains the characters to be
+					// read, if there are any available
+    int numIncoming;			// how many
+    int nextIncoming;			// the next one to hand out
+    bool atEnd;				// has the input run out?
 };
 
 class ConsoleOutput : public CallBackObj {
@@ -76,6 +84,11 @@ class ConsoleOutput : public CallBackObj {
     void PutChar(char ch);	// Write "ch" to the console display, 
 				// and return immediately.  "callWhenDone" 
 				// will called when the I/O completes. 
+    void PutBuffer(char *buf, int n);
+				// Same for "n" characters at once: one
+				// interrupt, when the last one is out
+    void Flush(char *buf, int n); // Write them with no interrupt at all,
+				// when shutting down
     void CallBack();		// Invoked when next character can be put
 				// out to the display.
     void PutInt(int n);         // Write n to the console display 
@@ -86,6 +99,7 @@ class ConsoleOutput : public CallBackObj {
 					// the next char can be put 
     bool putBusy;    			// Is a PutChar operation in progress?
 					// If so, you can't do another one!
+    int putCount;			// characters it is writing
 };
 
 #endif // CONSOLE_H
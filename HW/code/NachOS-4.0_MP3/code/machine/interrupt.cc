@@ -23,6 +23,7 @@
 #include "interrupt.h"
 #include "copyright.h"
 #include "main.h"
+#include "synchconsole.h"
 
 // String definitions for debugging messages
 
@@ -142,25 +143,34 @@ IntStatus Interrupt::SetLevel(IntStatus now) {
 void Interrupt::OneTick() {
   MachineStatus oldStatus = status;
   Statistics *stats = kernel->stats;
+  CPUSet *cpus = kernel->cpus;
+  int ticks;
 
   // advance simulated time
   if (status == SystemMode) {
-    stats->totalTicks += SystemTick;
+    ticks = SystemTick;
     stats->systemTicks += SystemTick;
   } else {
-    stats->totalTicks += UserTick;
+    ticks = UserTick;
     stats->userTicks += UserTick;
   }
+  if (cpus == NULL) {
+    stats->totalTicks += ticks;
+  } // else the core's own clock advances, below
   DEBUG(dbgInt, "== Tick " << stats->totalTicks << " ==");
 
   // check any pending interrupts are now ready to fire
   ChangeLevel(IntOn, IntOff); // first, turn off interrupts
                               // (interrupt handlers run with
                               // interrupts disabled)
+  if (cpus != NULL) {
+    cpus->Tick(ticks); // may give another core a turn
+  }
   CheckIfDue(FALSE);          // check for pending interrupts
   ChangeLevel(IntOff, IntOn); // re-enable interrupts
-  if (yieldOnReturn) {        // if the timer device handler asked
-                              // for a context switch, ok to do it now
+  // if the timer device handler asked for a context switch (on this
+  // core), ok to do it now
+  if (yieldOnReturn || (cpus != NULL && cpus->TakeResched())) {
     yieldOnReturn = FALSE;
     status = SystemMode; // yield is a kernel routine
     kernel->currentThread->Yield();
@@ -192,17 +202,32 @@ void Interrupt::YieldOnReturn() {
 //	on the ready queue, the only thing to do is to advance
 //	simulated time until the next scheduled hardware interrupt.
 //
+//	Rather than returning to Thread::Sleep after every interrupt
+//	(only to find the ready queue still empty and come straight
+//	back), we keep fast-forwarding the clock and draining every
+//	handler that is due, until one of them makes a thread ready.
+//
 //	If there are no pending interrupts, stop.  There's nothing
 //	more for us to do.
 //----------------------------------------------------------------------
 void Interrupt::Idle() {
+  Statistics *stats = kernel->stats;
+  bool fired = FALSE;
+
   DEBUG(dbgInt, "Machine idling; checking for interrupts.");
   status = IdleMode;
   DEBUG(dbgTraCode,
         "In Interrupt::Idle, into CheckIfDue, " << kernel->stats->totalTicks);
-  if (CheckIfDue(TRUE)) { // check for any pending interrupts
+  while (CheckIfDue(TRUE)) { // check for any pending interrupts
+    fired = TRUE;
+    if (!kernel->scheduler->IsEmpty()) {
+      break; // somebody is runnable now
+    }
+  }
+  if (fired) {
     DEBUG(dbgTraCode, "In Interrupt::Idle, return true from CheckIfDue, "
                           << kernel->stats->totalTicks);
+    stats->numIdleWakeups++;
     status = SystemMode;
     return; // return in case there's now
             // a runnable thread
@@ -226,9 +251,18 @@ void Interrupt::Idle() {
 // 	Shut down Nachos cleanly, printing out performance statistics.
 //----------------------------------------------------------------------
 void Interrupt::Halt() {
+  if (kernel->synchConsoleOut != NULL) {
+    kernel->synchConsoleOut->Drain(); // program output comes first
+  }
   cout << "Machine halting!\n\n";
   cout << "This is halt\n";
   kernel->stats->Print();
+  if (kernel->stats->reportFd >= 0) { // one program of a batch
+    kernel->predictor->SendHistory(kernel->stats->reportFd);
+  }
+  if (kernel->cpus != NULL) {
+    kernel->cpus->Print();
+  }
   delete kernel; // Never returns.
 }
 /*
@@ -295,6 +329,30 @@ void Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type) {
   pending->Insert(toOccur);
 }
 
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Take back the interrupt of type "type" that "toCall" scheduled
+//	earlier, if it has not fired yet.  Used by a device that is
+//	switched off (see Timer::Stop).
+//----------------------------------------------------------------------
+void Interrupt::Cancel(CallBackObj *toCall, IntType type) {
+  ListIterator<PendingInterrupt *> iter(pending);
+  PendingInterrupt *found = NULL;
+
+  for (; !iter.IsDone(); iter.Next()) {
+    if (iter.Item()->callOnInterrupt == toCall && iter.Item()->type == type) {
+      found = iter.Item();
+      break;
+    }
+  }
+  if (found != NULL) {
+    DEBUG(dbgInt, "Cancelling interrupt handler the "
+                      << intTypeNames[type] << " at time = " << found->when);
+    pending->Remove(found);
+    delete found;
+  }
+}
+
 //----------------------------------------------------------------------
 // Interrupt::CheckIfDue
 // 	Check if any interrupts are scheduled to occur, and if so,
@@ -327,6 +385,7 @@ bool Interrupt::CheckIfDue(bool advanceClock) {
     } else { // advance the clock to next interrupt
       stats->idleTicks += (next->when - stats->totalTicks);
       stats->totalTicks = next->when;
+      stats->numIdleSkips++;
       // UDelay(1000L); // rcgood - to stop nachos from spinning.
     }
   }
@@ -345,6 +404,9 @@ bool Interrupt::CheckIfDue(bool advanceClock) {
           "In Interrupt::CheckIfDue, into callOnInterrupt->CallBack, "
               << stats->totalTicks);
     next->callOnInterrupt->CallBack(); // call the interrupt handler
+    if (advanceClock) {
+      stats->numIdleHandlers++;
+    }
     DEBUG(dbgTraCode,
           "In Interrupt::CheckIfDue, return from callOnInterrupt->CallBack, "
               << stats->totalTicks);
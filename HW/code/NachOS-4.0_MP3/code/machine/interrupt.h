@@ -123,6 +123,8 @@ class Interrupt {
     				// Schedule an interrupt to occur
 				// at time "when".  This is called
     				// by the hardware device simulators.
+    void Cancel(CallBackObj *callTo, IntType type);
+				// Take a scheduled interrupt back
     
     void OneTick();       	// Advance simulated time
 
@@ -11,6 +11,11 @@
 #include "machine.h"
 #include "main.h"
 
+// The size of user memory, as set up by Kernel::Kernel.
+int PageSize = 1 << PAGE_SHIFT;
+int NumPhysPages = 128;
+int TLBSize = 4;
+
 // Textual names of the exceptions that can be generated by user program
 // execution, for debugging.
 static char* exceptionNames[] = { "no exception", "syscall", 
@@ -52,24 +57,32 @@ void CheckEndian()
 //		is executed.
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, bool useTLB)
 {
-    int i;
+    int i, cpu;
 
-    for (i = 0; i < NumTotalRegs; i++)
-        registers[i] = 0;
+    for (cpu = 0; cpu < MaxCPUs; cpu++)
+	for (i = 0; i < NumTotalRegs; i++)
+	    cpuRegisters[cpu][i] = 0;
+    SetCPU(0);
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
-    pageTable = NULL;
-#else	// use linear page table
-    tlb = NULL;
-    pageTable = NULL;
+    useTLB = TRUE;
 #endif
+    if (useTLB) {
+	tlb = new TranslationEntry[TLBSize];
+	for (i = 0; i < TLBSize; i++) {
+	    tlb[i].valid = FALSE;
+	    tlb[i].size = 1;
+	}
+	pageTable = NULL;
+    } else {		// use linear page table
+	tlb = NULL;
+	pageTable = NULL;
+    }
+    currentASID = 0;
 
     singleStep = debug;
     CheckEndian();
@@ -222,3 +235,17 @@ Machine::WriteRegister(int num, int value)
     registers[num] = value;
 }
 
+//----------------------------------------------------------------------
+// Machine::SetCPU
+//   	Switch to the register set of core "cpu".  The registers of the
+//	core we leave are kept as they are, for when it runs again.
+//----------------------------------------------------------------------
+
+void
+Machine::SetCPU(int cpu)
+{
+    ASSERT((cpu >= 0) && (cpu < MaxCPUs));
+    cpuNum = cpu;
+    registers = cpuRegisters[cpu];
+}
+
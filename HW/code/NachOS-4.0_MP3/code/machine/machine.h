@@ -26,19 +26,24 @@
 #include "translate.h"
 
 // Definitions related to the size, and format of user memory
+//
+// You are allowed to change these values, from the command line
+// (see Kernel::Kernel), before the machine is created; they stay
+// fixed from then on.
 
-const int PageSize = 128; 		// set the page size equal to
-					// the disk sector size, for simplicity
+#ifndef PAGE_SHIFT
+#define PAGE_SHIFT 7			// build with -DPAGE_SHIFT=n for
+#endif					// 2^n byte pages by default
+extern int PageSize;			// by default, set the page size
+					// equal to the disk sector size,
+					// for simplicity
+const int MaxSuperPage = 16;		// base pages one TLB entry can map
 
-//
-// You are allowed to change this value.
-// Doing so will change the number of pages of physical memory
-// available on the simulated machine.
-//
-const int NumPhysPages = 128;
+extern int NumPhysPages;		// pages of physical memory
+					// available on the simulated machine
 
-const int MemorySize = (NumPhysPages * PageSize);
-const int TLBSize = 4;			// if there is a TLB, make it small
+#define MemorySize (NumPhysPages * PageSize)
+extern int TLBSize;			// if there is a TLB, make it small
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -77,6 +82,12 @@ enum ExceptionType { NoException,           // Everything ok!
 
 #define NumTotalRegs 	40
 
+// The simulated machine may have several cores (see threads/cpu.h).
+// Each has its own set of the registers above; memory, and the
+// page table or TLB, are shared.
+
+const int MaxCPUs = 8;
+
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our 
@@ -95,8 +106,10 @@ class Interrupt;
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
-				// for running user programs
+    Machine(bool debug, bool useTLB);
+				// Initialize the simulation of the hardware
+				// for running user programs; with a TLB,
+				// instead of a page table, if "useTLB"
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -107,6 +120,11 @@ class Machine {
     void WriteRegister(int num, int value);
 				// store a value into a CPU register
 
+    void SetCPU(int cpu);	// make "cpu"'s registers the ones that
+				// user instructions and the routines
+				// above use
+    int getCPU() { return cpuNum; }
+
 // Data structures accessible to the Nachos kernel -- main memory and the
 // page table/TLB.
 //
@@ -136,6 +154,9 @@ class Machine {
 
     TranslationEntry *tlb;		// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int currentASID;			// TLB entries tagged with this
+					// address space ID are the ones
+					// that match
 
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
@@ -173,7 +194,11 @@ class Machine {
 
 // Internal data structures
 
-    int registers[NumTotalRegs]; // CPU registers, for executing user programs
+    int cpuRegisters[MaxCPUs][NumTotalRegs];
+				// CPU registers of each core
+    int *registers;		// CPU registers, for executing user programs:
+				// those of core "cpuNum"
+    int cpuNum;			// core executing user instructions
 
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
@@ -10,6 +10,7 @@
 #include "copyright.h"
 #include "debug.h"
 #include "stats.h"
+#include "sysdep.h"
 
 //----------------------------------------------------------------------
 // Statistics::Statistics
@@ -22,6 +23,27 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numPageIns = numPagesPrefetched = 0;
+    numCopyOnWrites = numPageCacheHits = numPageCacheMisses = 0;
+    numTLBHits = numTLBMisses = numSuperPageHits = 0;
+    numIdleSkips = numIdleHandlers = numIdleWakeups = 0;
+    numContextSwitches = numThreadsFinished = 0;
+    numTimerInts = 0;
+    for (int i = 0; i < MaxSyscalls; i++) {
+	numSyscalls[i] = syscallTicks[i] = 0;
+	syscallName[i] = NULL;
+    }
+    for (int i = 0; i < MaxSchedThreads; i++)
+	threadSched[i] = NULL;
+    schedFile = NULL;
+    reportFd = -1;
+    predictBias = 0;
+}
+
+Statistics::~Statistics()
+{
+    for (int i = 0; i < MaxSchedThreads; i++)
+	delete threadSched[i];
 }
 
 //----------------------------------------------------------------------
@@ -33,13 +55,358 @@ Statistics::Statistics()
 void
 Statistics::Print()
 {
+    if (reportFd >= 0) {
+	SendReport(reportFd);
+	return;
+    }
     cout << "Ticks: total " << totalTicks << ", idle " << idleTicks;
 		cout << ", system " << systemTicks << ", user " << userTicks <<"\n";
     cout << "Disk I/O: reads " << numDiskReads;
 		cout << ", writes " << numDiskWrites << "\n";
 		cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
-    cout << "Paging: faults " << numPageFaults << "\n";
+    cout << "Paging: faults " << numPageFaults;
+		cout << ", page-ins " << numPageIns;
+		cout << ", prefetched " << numPagesPrefetched;
+		cout << ", copy-on-write " << numCopyOnWrites;
+		cout << ", cache hits " << numPageCacheHits;
+		cout << ", misses " << numPageCacheMisses << "\n";
+    if (numTLBHits + numTLBMisses > 0) {
+	cout << "TLB: hits " << numTLBHits << ", misses " << numTLBMisses;
+	cout << ", hit rate "
+	     << 100.0 * numTLBHits / (numTLBHits + numTLBMisses) << "%";
+	cout << ", superpage hits " << numSuperPageHits << "\n";
+    }
     cout << "Network I/O: packets received " << numPacketsRecvd;
 		cout << ", sent " << numPacketsSent << "\n";
+    cout << "Idle: clock skips " << numIdleSkips;
+		cout << ", handlers " << numIdleHandlers;
+		cout << ", wakeups " << numIdleWakeups << "\n";
+    cout << "Timer: interrupts " << numTimerInts << "\n";
+    cout << "Scheduling: context switches " << numContextSwitches;
+		cout << ", threads finished " << numThreadsFinished;
+    if (totalTicks > 0)
+	cout << ", throughput "
+	     << (double) numThreadsFinished * 10000 / totalTicks
+	     << " per 10000 ticks";
+    cout << "\n";
+    PrintSched();
+    PrintSyscalls();
+    if (predictError.Count() > 0) {
+	predictError.Print("Burst prediction: errors");
+	cout << ", bias " << predictBias / predictError.Count() << "\n";
+    }
+    if (turnaround.Count() > 0) {
+	turnaround.Print("Turnaround: programs");
+	cout << "\n";
+    }
+    if (schedFile != NULL)
+	WriteSchedCSV(schedFile);
+}
+
+//----------------------------------------------------------------------
+// Statistics::SendReport, Statistics::AddReport
+// 	Pass the counters of one program of a batch run to the parent
+//	Nachos, which adds them up.  The programs ran side by side, so
+//	the simulated time of the batch is that of the longest one;
+//	everything else is summed.  The histograms stay behind.
+//----------------------------------------------------------------------
+
+const int NumReportCounters = 22;
+
+void
+Statistics::SendReport(int fd)
+{
+    int counters[NumReportCounters] = {
+	totalTicks, idleTicks, systemTicks, userTicks,
+	numDiskReads, numDiskWrites,
+	numConsoleCharsRead, numConsoleCharsWritten,
+	numPageFaults, numPacketsSent, numPacketsRecvd,
+	numContextSwitches, numThreadsFinished, numTimerInts,
+	numCopyOnWrites, numPageCacheHits, numPageCacheMisses,
+	numTLBHits, numTLBMisses, numSuperPageHits,
+	numPageIns, numPagesPrefetched };
+
+    WriteFile(fd, (char *) counters, sizeof(counters));
+}
+
+int
+Statistics::AddReport(int fd)
+{
+    int counters[NumReportCounters];
+
+    if (ReadPartial(fd, (char *) counters, sizeof(counters))
+	    != sizeof(counters))
+	return -1;			// it died before reporting
+    if (counters[0] > totalTicks)
+	totalTicks = counters[0];
+    idleTicks += counters[1];
+    systemTicks += counters[2];
+    userTicks += counters[3];
+    numDiskReads += counters[4];
+    numDiskWrites += counters[5];
+    numConsoleCharsRead += counters[6];
+    numConsoleCharsWritten += counters[7];
+    numPageFaults += counters[8];
+    numPacketsSent += counters[9];
+    numPacketsRecvd += counters[10];
+    numContextSwitches += counters[11];
+    numThreadsFinished += counters[12];
+    numTimerInts += counters[13];
+    numCopyOnWrites += counters[14];
+    numPageCacheHits += counters[15];
+    numPageCacheMisses += counters[16];
+    numTLBHits += counters[17];
+    numTLBMisses += counters[18];
+    numSuperPageHits += counters[19];
+    numPageIns += counters[20];
+    numPagesPrefetched += counters[21];
+    return counters[0];
+}
+
+//----------------------------------------------------------------------
+// Histogram::Histogram
+// 	Initialize an empty histogram.
+//----------------------------------------------------------------------
+
+Histogram::Histogram()
+{
+    for (int i = 0; i < NumHistBuckets; i++)
+	buckets[i] = 0;
+    count = max = 0;
+    sum = 0;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Record
+// 	Add a sample to the bucket holding it: bucket i > 0 holds
+//	[2^(i-1), 2^i), i.e. i is the number of significant bits.
+//----------------------------------------------------------------------
+
+void
+Histogram::Record(int value)
+{
+    int i = 0;
+
+    if (value < 0)
+	value = 0;
+    for (unsigned int v = value; v != 0; v >>= 1)
+	i++;
+    buckets[i]++;
+    count++;
+    sum += value;
+    if (value > max)
+	max = value;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Percentile
+// 	Return an upper bound on the "pct"-th percentile: the top of the
+//	bucket holding it, but never more than the largest sample.
+//----------------------------------------------------------------------
+
+int
+Histogram::Percentile(int pct)
+{
+    int rank = (count * pct + 99) / 100;	// rounded up
+    int seen = 0;
+
+    if (count == 0)
+	return 0;
+    if (rank < 1)
+	rank = 1;
+    for (int i = 0; i < NumHistBuckets - 1; i++) {
+	seen += buckets[i];
+	if (seen >= rank) {
+	    int top = (i == 0) ? 0 : (1 << i) - 1;
+	    return (top < max) ? top : max;
+	}
+    }
+    return max;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Print
+// 	Print a one-line summary, prefixed by "label".
+//----------------------------------------------------------------------
+
+void
+Histogram::Print(const char *label)
+{
+    cout << label << " " << count;
+    if (count > 0) {
+	cout << " (mean " << Mean() << ", p50 " << Percentile(50);
+	cout << ", p99 " << Percentile(99) << ", max " << max << ")";
+    }
+}
+
+SchedStats::SchedStats()
+{
+    name = NULL;
+    preemptions = 0;
+}
+
+//----------------------------------------------------------------------
+// Statistics::ThreadSched
+// 	Return the per-thread record for thread "id", allocating it the
+//	first time.  Threads beyond MaxSchedThreads are only counted per
+//	level.
+//----------------------------------------------------------------------
+
+SchedStats *
+Statistics::ThreadSched(int id, char *name)
+{
+    if (id < 0 || id >= MaxSchedThreads)
+	return NULL;
+    if (threadSched[id] == NULL) {
+	threadSched[id] = new SchedStats;
+	threadSched[id]->name = name;
+    }
+    return threadSched[id];
+}
+
+//----------------------------------------------------------------------
+// Statistics::RecordWait, Statistics::RecordBurst
+// 	Called by the scheduler when a thread is dispatched from ready
+//	queue "level" (1..NumSchedLevels), and when a thread leaves the
+//	CPU, respectively.
+//----------------------------------------------------------------------
+
+void
+Statistics::RecordWait(int id, char *name, int level, int ticks)
+{
+    SchedStats *t = ThreadSched(id, name);
+
+    ASSERT(level >= 1 && level <= NumSchedLevels);
+    levelSched[level - 1].wait.Record(ticks);
+    if (t != NULL)
+	t->wait.Record(ticks);
+}
+
+void
+Statistics::RecordBurst(int id, char *name, int level, int ticks,
+			bool preempted)
+{
+    SchedStats *t = ThreadSched(id, name);
+
+    ASSERT(level >= 1 && level <= NumSchedLevels);
+    levelSched[level - 1].burst.Record(ticks);
+    if (preempted)
+	levelSched[level - 1].preemptions++;
+    if (t != NULL) {
+	t->burst.Record(ticks);
+	if (preempted)
+	    t->preemptions++;
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::RecordPrediction
+// 	Score a CPU burst prediction against the burst that happened.
+//	The bias is positive if bursts are overestimated on average.
+//----------------------------------------------------------------------
+
+void
+Statistics::RecordPrediction(double predicted, int actual)
+{
+    double diff = predicted - actual;
+
+    predictError.Record((int)(diff < 0 ? -diff : diff));
+    predictBias += diff;
+}
+
+//----------------------------------------------------------------------
+// Statistics::PrintSched
+// 	Print the scheduling latency (wait) and burst histograms for
+//	every queue level and every thread that was ever dispatched.
+//----------------------------------------------------------------------
+
+void
+Statistics::PrintSched()
+{
+    for (int i = 0; i < NumSchedLevels; i++) {
+	SchedStats *l = &levelSched[i];
+	if (l->wait.Count() == 0 && l->burst.Count() == 0)
+	    continue;
+	cout << "Scheduling L" << i + 1 << ": ";
+	l->wait.Print("waits");
+	l->burst.Print(", bursts");
+	cout << ", preemptions " << l->preemptions << "\n";
+    }
+    for (int i = 0; i < MaxSchedThreads; i++) {
+	SchedStats *t = threadSched[i];
+	if (t == NULL)
+	    continue;
+	cout << "Scheduling thread " << i << " (" << t->name << "): ";
+	t->wait.Print("waits");
+	t->burst.Print(", bursts");
+	cout << ", preemptions " << t->preemptions << "\n";
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::PrintSyscalls
+// 	Print how often each system call was made, and how long it took
+//	on average (in ticks, including any time the caller was
+//	blocked).  System calls that never returned, like Exit, only
+//	count as calls.
+//----------------------------------------------------------------------
+
+void
+Statistics::PrintSyscalls()
+{
+    for (int i = 0; i < MaxSyscalls; i++) {
+	if (numSyscalls[i] == 0)
+	    continue;
+	cout << "Syscall " << syscallName[i] << ": calls " << numSyscalls[i];
+	cout << ", ticks " << syscallTicks[i];
+	cout << ", average " << (double) syscallTicks[i] / numSyscalls[i];
+	cout << "\n";
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::WriteSchedCSV
+// 	Dump the scheduling statistics to "fileName", one row per
+//	(level or thread, metric), for offline tuning of the scheduler.
+//----------------------------------------------------------------------
+
+static void
+WriteSchedRow(int fd, const char *scope, int id, char *name,
+	      const char *metric, Histogram *h, int preemptions)
+{
+    char row[512];
+
+    snprintf(row, sizeof(row), "%s,%d,%s,%s,%d,%.1f,%d,%d,%d,%d,%d\n",
+	     scope, id, (name != NULL) ? name : "", metric, h->Count(),
+	     h->Mean(), h->Percentile(50), h->Percentile(90),
+	     h->Percentile(99), h->Max(), preemptions);
+    WriteFile(fd, row, strlen(row));
+}
+
+void
+Statistics::WriteSchedCSV(char *fileName)
+{
+    char header[] =
+	"scope,id,name,metric,count,mean,p50,p90,p99,max,preemptions\n";
+    int fd = OpenForWrite(fileName);
+
+    WriteFile(fd, header, strlen(header));
+    for (int i = 0; i < NumSchedLevels; i++) {
+	SchedStats *l = &levelSched[i];
+	WriteSchedRow(fd, "level", i + 1, NULL, "wait", &l->wait,
+		      l->preemptions);
+	WriteSchedRow(fd, "level", i + 1, NULL, "burst", &l->burst,
+		      l->preemptions);
+    }
+    for (int i = 0; i < MaxSchedThreads; i++) {
+	SchedStats *t = threadSched[i];
+	if (t == NULL)
+	    continue;
+	WriteSchedRow(fd, "thread", i, t->name, "wait", &t->wait,
+		      t->preemptions);
+	WriteSchedRow(fd, "thread", i, t->name, "burst", &t->burst,
+		      t->preemptions);
+    }
+    Close(fd);
 }
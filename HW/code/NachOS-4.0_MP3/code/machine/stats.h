@@ -13,6 +13,50 @@
 
 #include "copyright.h"
 
+// The following class defines a histogram of tick counts, on a log
+// scale: bucket 0 counts zeros, bucket i counts values in
+// [2^(i-1), 2^i).  Percentiles are therefore only accurate to within
+// a factor of two, which is plenty for spotting tail latency.
+
+const int NumHistBuckets = 32;
+
+class Histogram {
+  public:
+    Histogram();		// initialize an empty histogram
+
+    void Record(int value);	// add a sample (negative counts as 0)
+    int Count() { return count; }
+    int Percentile(int pct);	// upper bound on the pct-th percentile
+    double Mean() { return count ? sum / count : 0; }
+    int Max() { return max; }
+
+    void Print(const char *label);	// one-line summary
+
+  private:
+    int buckets[NumHistBuckets];
+    int count;			// number of samples
+    double sum;			// sum of the samples
+    int max;			// largest sample
+};
+
+// Scheduling statistics, kept both per ready queue level and per thread.
+
+const int NumSchedLevels = 3;	// L1, L2, L3
+const int MaxSchedThreads = 32;	// threads tracked individually (by ID)
+
+const int MaxSyscalls = 128;	// system call codes (see syscall.h)
+
+class SchedStats {
+  public:
+    SchedStats();
+
+    char *name;			// thread name, NULL for a level
+    Histogram wait;		// ticks from ReadyToRun to dispatch
+    Histogram burst;		// ticks on the CPU per dispatch
+    int preemptions;		// bursts that ended with the thread
+				// still runnable
+};
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -33,12 +77,65 @@ class Statistics {
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numPageIns;		// reads of program pages, on faults
+    int numPagesPrefetched;	// pages brought in ahead of a fault
+    int numCopyOnWrites;	// shared pages copied when written
+    int numPageCacheHits;	// program pages found already in memory
+    int numPageCacheMisses;	// ... and read from the file
+    int numTLBHits;		// translations found in the TLB
+    int numTLBMisses;		// ... and not (each one a page fault)
+    int numSuperPageHits;	// hits on entries mapping several pages
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
+    int numIdleSkips;		// number of times the idle loop fast-forwarded
+				// the clock to the next pending interrupt
+    int numIdleHandlers;	// interrupt handlers run while idle
+    int numIdleWakeups;		// times the idle loop handed control back
+				// to the scheduler
+    int numContextSwitches;	// times the CPU went to another thread
+    int numThreadsFinished;	// threads that ran to completion
+    int numTimerInts;		// timer interrupts handled
+
+    int numSyscalls[MaxSyscalls];	// calls of each system call
+    int syscallTicks[MaxSyscalls];	// ... and ticks until they returned
+    const char *syscallName[MaxSyscalls];	// set by the dispatcher
+
+    SchedStats levelSched[NumSchedLevels];	// per ready queue level
+    SchedStats *threadSched[MaxSchedThreads];	// per thread, by ID
+    char *schedFile;		// if set, Print also writes the
+				// scheduling statistics here, as CSV
+    int reportFd;		// if >= 0, we are running one program of
+				// a batch (-par), and Print sends the
+				// counters here, to the parent, instead
+
+    Histogram predictError;	// |predicted - actual| CPU burst
+    double predictBias;		// sum of (predicted - actual)
+    Histogram turnaround;	// fork to exit of user programs
+
     Statistics(); 		// initialize everything to zero
+    ~Statistics();
+
+    void RecordWait(int id, char *name, int level, int ticks);
+				// a thread was dispatched from "level"
+				// after waiting "ticks"
+    void RecordBurst(int id, char *name, int level, int ticks,
+		     bool preempted);
+				// a thread left the CPU after "ticks"
+    void RecordPrediction(double predicted, int actual);
+				// score a CPU burst prediction
 
     void Print();		// print collected statistics
+    void PrintSched();		// print scheduling statistics
+    void PrintSyscalls();	// print system call statistics
+    void WriteSchedCSV(char *fileName);
+				// dump scheduling statistics as CSV
+    void SendReport(int fd);	// write the counters to a pipe
+    int AddReport(int fd);	// add the counters read from a pipe;
+				// return their totalTicks, -1 if none
+
+  private:
+    SchedStats *ThreadSched(int id, char *name);
 };
 
 // Constants used to reflect the relative time an operation would
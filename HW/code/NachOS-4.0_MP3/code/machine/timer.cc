@@ -40,7 +40,34 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
     randomize = doRandom;
     callPeriodically = toCall;
     disable = FALSE;
-    SetInterrupt();
+    running = armed = FALSE;
+    Start();
+}
+
+//----------------------------------------------------------------------
+// Timer::Start, Timer::Stop
+//      Start or stop generating interrupts.  A stopped timer has
+//	nothing pending, so it costs nothing while there is no time
+//	slicing to do (see Alarm::UpdateTimer).  Started again, it
+//	counts a fresh delay from now.
+//----------------------------------------------------------------------
+
+void
+Timer::Start()
+{
+    running = TRUE;
+    if (!armed)
+	SetInterrupt();
+}
+
+void
+Timer::Stop()
+{
+    running = FALSE;
+    if (armed) {
+	kernel->interrupt->Cancel(this, TimerInt);
+	armed = FALSE;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -52,10 +79,12 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
 void 
 Timer::CallBack() 
 {
+    armed = FALSE;
     // invoke the Nachos interrupt handler for this device
     callPeriodically->CallBack();
     
-    SetInterrupt();	// do last, to let software interrupt handler
+    if (running)
+	SetInterrupt();	// do last, to let software interrupt handler
     			// decide if it wants to disable future interrupts
 }
 
@@ -77,5 +106,6 @@ Timer::SetInterrupt()
         }
        // schedule the next timer device interrupt
        kernel->interrupt->Schedule(this, delay, TimerInt);
+       armed = TRUE;
     }
 }
@@ -36,11 +36,18 @@ class Timer : public CallBackObj {
     				// Turn timer device off, so it doesn't
 				// generate any more interrupts.
 
+    void Start();		// start ticking, if stopped
+    void Stop();		// stop ticking, and take back the
+				// interrupt already scheduled
+    bool IsRunning() { return running; }
+
   private:
     bool randomize;		// set if we need to use a random timeout delay
     CallBackObj *callPeriodically; // call this every TimerTicks time units 
     bool disable;		// turn off the timer device after next
     				// interrupt.
+    bool running;		// set between Start and Stop
+    bool armed;			// an interrupt is scheduled
     
     void CallBack();		// called internally when the hardware
 				// timer generates an interrupt
@@ -216,16 +216,22 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	entry = &pageTable[vpn];
     } else {
         for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn))) {
+    	    if (tlb[i].valid && tlb[i].asid == currentASID &&
+		    (tlb[i].virtualPage == ((int)vpn & ~(tlb[i].size - 1)))) {
 		entry = &tlb[i];			// FOUND!
 		break;
 	    }
 	if (entry == NULL) {				// not found
     	    DEBUG(dbgAddr, "Invalid TLB entry for this virtual page!");
+	    kernel->stats->numTLBMisses++;
     	    return PageFaultException;		// really, this is a TLB fault,
 						// the page may be in memory,
 						// but not in the TLB
 	}
+	kernel->stats->numTLBHits++;
+	entry->lastUse = kernel->stats->numTLBHits;	// a clock, for LRU
+	if (entry->size > 1)
+	    kernel->stats->numSuperPageHits++;
     }
 
     if (entry->readOnly && writing) {	// trying to write to a read-only page
@@ -233,10 +239,12 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	return ReadOnlyException;
     }
     pageFrame = entry->physicalPage;
+    if (tlb != NULL)			// maybe a superpage
+	pageFrame += vpn - entry->virtualPage;
 
     // if the pageFrame is too big, there is something really wrong! 
     // An invalid translation was loaded into the page table or TLB. 
-    if (pageFrame >= NumPhysPages) { 
+    if (pageFrame >= (unsigned) NumPhysPages) { 
 	DEBUG(dbgAddr, "Illegal pageframe " << pageFrame);
 	return BusErrorException;
     }
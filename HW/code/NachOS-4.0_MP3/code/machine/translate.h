@@ -40,6 +40,13 @@ class TranslationEntry {
 			// page is referenced or modified.
     bool dirty;         // This bit is set by the hardware every time the
 			// page is modified.
+    int size;		// Number of pages mapped, starting at virtualPage
+			// and physicalPage (TLB only): 1, or a power of
+			// two for a superpage, which both page numbers
+			// are then multiples of.
+    int asid;		// The address space the entry belongs to (TLB
+			// only): it matches only while that one runs.
+    int lastUse;	// When it was last hit (TLB only), for LRU.
 };
 
 #endif
@@ -0,0 +1,33 @@
+#include "syscall.h"
+
+int main(void)
+{
+	// a file opened by a program is never read from or written to
+	// the console, whatever id it gets
+	char test[] = "abcdefghijklmnopqrstuvwxyz";
+	char back[26];
+	OpenFileId fid;
+	int count, success, i;
+	success = Create("file3.test");
+	if (success != 1) MSG("Failed on creating file");
+	fid = Open("file3.test");
+	if (fid < 0) MSG("Failed on opening file");
+	if (fid == SysConsoleInput || fid == SysConsoleOutput)
+		MSG("Failed: file got a console id");
+	count = Write(test, 26, fid);
+	if (count != 26) MSG("Failed on writing file");
+	success = Close(fid);
+	if (success != 1) MSG("Failed on closing file");
+
+	fid = Open("file3.test");
+	if (fid < 0) MSG("Failed on opening file");
+	count = Read(back, 26, fid);
+	if (count != 26) MSG("Failed on reading file");
+	success = Close(fid);
+	if (success != 1) MSG("Failed on closing file");
+	for (i = 0; i < 26; ++i) {
+		if (back[i] != test[i]) MSG("Failed: reading wrong result");
+	}
+	MSG("Passed! ^_^");
+	Halt();
+}
@@ -0,0 +1,16 @@
+/* join_child.c
+ *	Child of join_test: gives the other threads a chance to run for
+ *	a while, then exits with 100 + argc.
+ */
+
+#include "syscall.h"
+
+int
+main(int argc, char **argv)
+{
+    int i;
+
+    for (i = 0; i < 20; i++)
+	ThreadYield();
+    Exit(100 + argc);
+}
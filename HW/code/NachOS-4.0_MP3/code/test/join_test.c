@@ -0,0 +1,32 @@
+/* join_test.c
+ *	Test that Join waits for a process whose SpaceId was used before.
+ *	Run it as
+ *
+ *		nachos -e join_child -e join_test
+ *
+ *	The first join_child has no parent, so its entry is freed when it
+ *	exits, and the join_child started here gets the same SpaceId.
+ *	Join must still wait for it, and return its own exit status
+ *	(102: it has two arguments), not the first one's (100).
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+    char *args[2];
+    SpaceId id;
+    int i, status;
+
+    for (i = 0; i < 100; i++)	/* let the first join_child finish */
+	ThreadYield();
+    args[0] = "join_child";
+    args[1] = "again";
+    id = ExecV(2, args);
+    if (id < 0) MSG("Failed on Exec");
+    status = Join(id);
+    if (status != 102) MSG("Failed: Join did not wait for the child");
+    else MSG("Passed! ^_^");
+    Halt();
+}
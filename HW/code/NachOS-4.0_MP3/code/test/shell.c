@@ -4,9 +4,8 @@ int
 main()
 {
     SpaceId newProc;
-    OpenFileId input = ConsoleInput;
-    OpenFileId output = ConsoleOutput;
-    char prompt[2], ch, buffer[60];
+    OpenFileId output = SysConsoleOutput;
+    char prompt[2], buffer[60];
     int i;
 
     prompt[0] = '-';
@@ -16,15 +15,12 @@ main()
     {
 	Write(prompt, 2, output);
 
-	i = 0;
-	
-	do {
-	
-	    Read(&buffer[i], 1, input); 
-
-	} while( buffer[i++] != '\n' );
-
-	buffer[--i] = '\0';
+	i = ReadLine(buffer, 59);
+	if( i == 0 )
+	    Halt();		/* end of input */
+	if( buffer[i - 1] == '\n' )
+	    i--;
+	buffer[i] = '\0';
 
 	if( i > 0 ) {
 		newProc = Exec(buffer);
@@ -1,8 +1,7 @@
 // alarm.cc
 //	Routines to use a hardware timer device to provide a
-//	software alarm clock.  For now, we just provide time-slicing.
-//
-//	Not completely implemented.
+//	software alarm clock: time-slicing, and putting threads to
+//	sleep for a while.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -12,15 +11,38 @@
 #include "copyright.h"
 #include "main.h"
 
+//----------------------------------------------------------------------
+// SleeperCompare
+//	Order sleepers by wakeup time, then by arrival.
+//----------------------------------------------------------------------
+
+static int SleeperCompare(Sleeper *x, Sleeper *y) {
+  if (x->when != y->when) {
+    return (x->when < y->when) ? -1 : 1;
+  }
+  if (x->seq != y->seq) {
+    return (x->seq < y->seq) ? -1 : 1;
+  }
+  return 0;
+}
+
 //----------------------------------------------------------------------
 // Alarm::Alarm
 //      Initialize a software alarm clock.  Start up a timer device
 //
 //      "doRandom" -- if true, arrange for the hardware interrupts to
 //		occur at random, instead of fixed, intervals.
+//      "noTicks" -- if true, only keep the timer running while it
+//		has work to do (see UpdateTimer).
 //----------------------------------------------------------------------
 
-Alarm::Alarm(bool doRandom) { timer = new Timer(doRandom, this); }
+Alarm::Alarm(bool doRandom, bool noTicks) {
+  tickless = noTicks;
+  sleepers = new Heap<Sleeper *>(SleeperCompare);
+  numSleeps = 0;
+  timer = new Timer(doRandom, this); // stopped by the first
+                                     // UpdateTimer, if need be
+}
 
 //----------------------------------------------------------------------
 // Alarm::CallBack
@@ -38,17 +60,106 @@ Alarm::Alarm(bool doRandom) { timer = new Timer(doRandom, this); }
 //
 //	For now, just provide time-slicing.  Only need to time slice
 //      if we're currently running something (in other words, not idle).
+//	The running address space also samples its working set here,
+//	if it is being profiled (see pageprofile.h).
 //----------------------------------------------------------------------
 
 void Alarm::CallBack() {
   Interrupt *interrupt = kernel->interrupt;
   MachineStatus status = interrupt->getStatus();
 
+  kernel->stats->numTimerInts++;
+  WakeUp();
   if (status != IdleMode) {
+    if (kernel->currentThread->space != NULL) {
+      kernel->currentThread->space->SampleWorkingSet();
+    }
 
     // kernel->scheduler->Aging();
     // kernel->scheduler->ReArrangeThreads();
 
-    interrupt->YieldOnReturn();
+    if (kernel->cpus != NULL) {
+      kernel->cpus->PreemptAll(); // every core has a timer
+    } else {
+      interrupt->YieldOnReturn();
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+// Alarm::UpdateTimer
+//	In tickless mode, the timer only runs when a timer interrupt
+//	could change anything: when some thread is waiting in the ready
+//	queue, to be aged or time sliced against the running one, or
+//	when some thread is sleeping.  With a single runnable thread,
+//	or none at all, and no sleepers, it is stopped, and
+//	Interrupt::Idle skips straight to the next device interrupt.
+//
+//	Called whenever the ready queue or the sleepers change, with
+//	interrupts disabled.  Several cores share the one timer, and
+//	each core's ready queue is its own, so there the timer keeps
+//	running.
+//----------------------------------------------------------------------
+
+void Alarm::UpdateTimer() {
+  bool needed;
+
+  if (!tickless) {
+    return;
+  }
+  needed = (kernel->cpus != NULL) || !kernel->scheduler->IsEmpty() ||
+           !sleepers->IsEmpty();
+  if (needed && !timer->IsRunning()) {
+    DEBUG(dbgInt, "Timer started at " << kernel->stats->totalTicks);
+    timer->Start();
+  } else if (!needed && timer->IsRunning()) {
+    DEBUG(dbgInt, "Timer stopped at " << kernel->stats->totalTicks);
+    timer->Stop();
+  }
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+//	Put the current thread to sleep for "x" ticks.  It wakes up at
+//	the first timer interrupt at or after now + x, so it may sleep
+//	up to a time slice longer than asked.
+//
+//	Unlike a busy loop, the sleep takes no CPU time: the thread is
+//	not on the ready queue until it is due.
+//----------------------------------------------------------------------
+
+void Alarm::WaitUntil(int x) {
+  IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+  Sleeper sleeper; // on our stack, which stays put while we sleep
+
+  if (x > 0) {
+    sleeper.thread = kernel->currentThread;
+    sleeper.when = kernel->stats->totalTicks + x;
+    sleeper.seq = numSleeps++;
+    sleepers->Insert(&sleeper);
+    DEBUG(dbgThread, "Sleeping thread: " << sleeper.thread->getName()
+                                         << " until " << sleeper.when);
+    UpdateTimer();
+    kernel->currentThread->Sleep(FALSE);
+  }
+  (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::WakeUp
+//	Called at every timer interrupt: move every sleeper that is due
+//	to the ready queue, all at once.
+//----------------------------------------------------------------------
+
+void Alarm::WakeUp() {
+  int now = kernel->stats->totalTicks;
+
+  while (!sleepers->IsEmpty() && sleepers->Min()->when <= now) {
+    Sleeper *sleeper = sleepers->RemoveMin();
+
+    DEBUG(dbgThread, "Waking thread: " << sleeper->thread->getName()
+                                       << ", due at " << sleeper->when);
+    kernel->scheduler->ReadyToRun(sleeper->thread);
   }
+  UpdateTimer();
 }
@@ -8,7 +8,10 @@
 //	From this, we provide the ability for a thread to be
 //	woken up after a delay; we also provide time-slicing.
 //
-//	NOTE: this abstraction is not completely implemented.
+//	Sleeping threads wait in a heap ordered by wakeup time; they
+//	cost nothing until the timer interrupt at (or after) their
+//	wakeup time puts them, and everybody else due by then, back on
+//	the ready queue.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -21,19 +24,41 @@
 #include "utility.h"
 #include "callback.h"
 #include "timer.h"
+#include "heap.h"
+
+class Thread;
+
+// A thread blocked in WaitUntil.  Ties are broken by "seq", so that
+// threads due at the same time wake in the order they went to sleep.
+
+class Sleeper {
+  public:
+    Thread *thread;		// who is sleeping
+    int when;			// wake up at this time
+    int seq;			// order of arrival
+};
 
 // The following class defines a software alarm clock. 
 class Alarm : public CallBackObj {
   public:
-    Alarm(bool doRandomYield);	// Initialize the timer, and callback 
+    Alarm(bool doRandomYield, bool tickless);
+				// Initialize the timer, and callback 
 				// to "toCall" every time slice.
-    ~Alarm() { delete timer; }
+    ~Alarm() { delete timer; delete sleepers; }
     
-    void WaitUntil(int x);	// suspend execution until time > now + x
-                                // this method is not yet implemented
+    void WaitUntil(int x);	// suspend execution until time >= now + x
+
+    void UpdateTimer();		// in tickless mode, start or stop the
+				// timer, as the ready queue changed
 
   private:
     Timer *timer;		// the hardware timer device
+    bool tickless;		// stop the timer when it has nothing
+				// to do
+    Heap<Sleeper *> *sleepers;	// threads in WaitUntil, soonest first
+    int numSleeps;		// sleeps so far, to order ties
+
+    void WakeUp();		// make the sleepers that are due ready
 
     void CallBack();		// called when the hardware
 				// timer generates an interrupt
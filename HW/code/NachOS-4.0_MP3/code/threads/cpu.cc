@@ -0,0 +1,326 @@
+// cpu.cc
+//	Routines for interleaving several simulated cores on the host.
+//
+//	Every core has an idle thread, which the core runs when its
+//	ready queue is empty.  Idle threads never go on a ready queue:
+//	Thread::Sleep switches to the idle thread of its core directly,
+//	and the idle thread switches to a ready thread when one shows
+//	up, either on its own queue or on another core's.
+//
+//	A core that is not active is always stopped inside Switch, so
+//	switching back to it resumes it there.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "cpu.h"
+#include "copyright.h"
+#include "debug.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// CPU::CPU
+// 	Initialize a core that has nothing to run yet.
+//----------------------------------------------------------------------
+
+CPU::CPU(int cpuID, Scheduler *sched) {
+  id = cpuID;
+  scheduler = sched;
+  current = idleThread = NULL;
+  ticks = 0;
+  resched = FALSE;
+  busyTicks = steals = 0;
+}
+
+//----------------------------------------------------------------------
+// IdleLoop
+// 	The body of the idle thread of a core.  Run whatever becomes
+//	ready on this core, or can be stolen from another; otherwise let
+//	the other cores run, or wait for an interrupt if they are all
+//	idle too.
+//----------------------------------------------------------------------
+
+static void IdleLoop(CPU *cpu) {
+  Thread *next;
+
+  (void)kernel->interrupt->SetLevel(IntOff);
+  for (;;) {
+    ASSERT(kernel->cpus->Current() == cpu);
+    next = kernel->scheduler->Scheduling();
+    if (next != NULL) {
+      kernel->currentThread->setStatus(BLOCKED);
+      kernel->scheduler->Run(next, FALSE);
+    } else {
+      kernel->cpus->WaitForWork();
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+// CPUSet::CPUSet
+// 	Set up "n" cores.  The thread running now, and the existing
+//	ready queue, become those of core 0; the other cores start out
+//	running their idle thread.
+//----------------------------------------------------------------------
+
+CPUSet::CPUSet(int n, SchedPolicy policy, Quanta *quanta) {
+  ASSERT(n >= 1 && n <= MaxCPUs);
+  numCPUs = n;
+  for (int i = 0; i < numCPUs; i++) {
+    CPU *cpu = new CPU(i, (i == 0) ? kernel->scheduler : new Scheduler(policy, quanta));
+    char *name = new char[16];
+
+    sprintf(name, "idle %d", i);
+    cpu->idleThread = new Thread(name, -1);
+    cpu->idleThread->Prepare((VoidFunctionPtr)IdleLoop, (void *)cpu);
+    cpu->idleThread->setStatus(RUNNING);
+    cpu->current = cpu->idleThread;
+    cpus[i] = cpu;
+  }
+  active = cpus[0];
+  active->current = kernel->currentThread;
+  active->ticks = kernel->stats->totalTicks;
+  DEBUG(dbgThread, "Simulating " << numCPUs << " cores");
+}
+
+//----------------------------------------------------------------------
+// CPUSet::~CPUSet
+// 	Free the cores.  kernel->scheduler, and the thread that is
+//	running, belong to the kernel.
+//----------------------------------------------------------------------
+
+CPUSet::~CPUSet() {
+  for (int i = 0; i < numCPUs; i++) {
+    if (cpus[i]->scheduler != kernel->scheduler) {
+      delete cpus[i]->scheduler;
+    }
+    if (cpus[i]->idleThread != kernel->currentThread) {
+      delete cpus[i]->idleThread;
+    }
+    delete cpus[i];
+  }
+}
+
+//----------------------------------------------------------------------
+// CPUSet::Tick
+// 	Called from Interrupt::OneTick, with interrupts disabled, after
+//	the active core did "ticks" worth of work.  Once the core has
+//	used up its quantum, give the next core a turn.
+//
+//	An idle core's clock stands still; it catches up with the
+//	global clock when the core starts running again.
+//----------------------------------------------------------------------
+
+void CPUSet::Tick(int ticks) {
+  CPU *next;
+
+  ASSERT(kernel->interrupt->getLevel() == IntOff);
+  if (active->ticks < kernel->stats->totalTicks) {
+    active->ticks = kernel->stats->totalTicks;
+  }
+  active->ticks += ticks;
+  if (kernel->currentThread != active->idleThread) {
+    active->busyTicks += ticks;
+  }
+  if (active->ticks < kernel->stats->totalTicks + CPUQuantum) {
+    return;
+  }
+  next = NextCPU();
+  if (next != NULL) {
+    Switch(next);
+  }
+}
+
+//----------------------------------------------------------------------
+// CPUSet::PreemptAll, CPUSet::TakeResched
+// 	Every core has a timer; they are all driven by the one Alarm.
+//	The active core notices its request for a context switch at
+//	its next tick, and the others when they get their turn.  Idle
+//	threads never yield.
+//----------------------------------------------------------------------
+
+void CPUSet::PreemptAll() {
+  for (int i = 0; i < numCPUs; i++) {
+    cpus[i]->resched = TRUE;
+  }
+}
+
+bool CPUSet::TakeResched() {
+  bool resched = active->resched;
+
+  active->resched = FALSE;
+  return resched && kernel->currentThread != active->idleThread;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::AgeOthers
+// 	Called on the active core's time slice: the threads waiting on
+//	the other cores' queues have been waiting just as long.
+//----------------------------------------------------------------------
+
+void CPUSet::AgeOthers() {
+  for (int i = 0; i < numCPUs; i++) {
+    if (cpus[i] != active) {
+      cpus[i]->scheduler->Age();
+    }
+  }
+}
+
+//----------------------------------------------------------------------
+// CPUSet::Steal
+// 	Called by a core with an empty ready queue.  Take a ready thread
+//	from the core with the most of them.
+//----------------------------------------------------------------------
+
+Thread *CPUSet::Steal() {
+  CPU *victim = NULL;
+  Thread *thread;
+
+  for (int i = 0; i < numCPUs; i++) {
+    CPU *cpu = cpus[i];
+    if (cpu != active && cpu->scheduler->NumReady() > 0 &&
+        (victim == NULL ||
+         cpu->scheduler->NumReady() > victim->scheduler->NumReady())) {
+      victim = cpu;
+    }
+  }
+  if (victim == NULL) {
+    return NULL;
+  }
+  thread = victim->scheduler->Detach();
+  active->steals++;
+  DEBUG(dbgThread, "CPU " << active->id << " steals " << thread->getName()
+                          << " from CPU " << victim->id);
+  return thread;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::WaitForWork
+// 	Called by the idle thread of the active core, when there is
+//	nothing to run or steal.  Let the other cores run; if they are
+//	all idle, advance the clock to the next interrupt.
+//----------------------------------------------------------------------
+
+void CPUSet::WaitForWork() {
+  CPU *next = NextCPU();
+
+  if (next != NULL) {
+    Switch(next);
+  } else {
+    kernel->interrupt->Idle();
+  }
+}
+
+//----------------------------------------------------------------------
+// CPUSet::HasWork
+// 	A core should get a turn if it is running a thread, or if it is
+//	idle but could steal one.
+//----------------------------------------------------------------------
+
+bool CPUSet::HasWork(CPU *cpu) {
+  Thread *running = (cpu == active) ? kernel->currentThread : cpu->current;
+
+  if (running != cpu->idleThread) {
+    return TRUE;
+  }
+  for (int i = 0; i < numCPUs; i++) {
+    if (cpus[i]->scheduler->NumReady() > 0) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+//----------------------------------------------------------------------
+// CPUSet::NextCPU
+// 	Return the next core, after the active one, that has work and
+//	has not had its quantum yet.  If all of them have, start the
+//	next quantum of the global clock.  Return NULL if no core has
+//	anything to do.
+//----------------------------------------------------------------------
+
+CPU *CPUSet::NextCPU() {
+  Statistics *stats = kernel->stats;
+  bool anyWork = FALSE;
+
+  for (int round = 0; round < 2; round++) {
+    int end = stats->totalTicks + CPUQuantum;
+
+    for (int i = 1; i <= numCPUs; i++) {
+      CPU *cpu = cpus[(active->id + i) % numCPUs];
+      if (HasWork(cpu)) {
+        anyWork = TRUE;
+        if (cpu->ticks < end) {
+          return cpu;
+        }
+      }
+    }
+    if (!anyWork) {
+      return NULL;
+    }
+    stats->totalTicks = end; // everyone had their turn
+  }
+  ASSERT(FALSE); // a core's clock is never a full
+  return NULL;   // quantum past the end of a round
+}
+
+//----------------------------------------------------------------------
+// CPUSet::Switch
+// 	Stop the active core and resume "next", where it stopped.  The
+//	registers of each core stay in the machine; only the address
+//	space (page table) has to be switched.
+//
+//	Interrupts must be disabled.  Returns when some core switches
+//	back to this one.
+//----------------------------------------------------------------------
+
+void CPUSet::Switch(CPU *next) {
+  Interrupt *interrupt = kernel->interrupt;
+  Thread *oldThread = kernel->currentThread;
+  MachineStatus status = interrupt->getStatus();
+
+  ASSERT(interrupt->getLevel() == IntOff);
+  if (next == active) {
+    return;
+  }
+  if (oldThread->space != NULL) {
+    oldThread->space->SaveState();
+  }
+  active->current = oldThread;
+
+  active = next;
+  kernel->currentThread = next->current;
+  kernel->scheduler = next->scheduler;
+  kernel->machine->SetCPU(next->id);
+  if (next->ticks < kernel->stats->totalTicks) {
+    next->ticks = kernel->stats->totalTicks;
+  }
+  DEBUG(dbgThread, "Switching to CPU " << next->id << ", running "
+                                       << next->current->getName());
+
+  interrupt->setStatus(SystemMode);
+  SWITCH(oldThread, next->current);
+
+  // we're back, on the core running oldThread
+  ASSERT(interrupt->getLevel() == IntOff);
+  interrupt->setStatus(status);
+  if (oldThread->space != NULL) {
+    oldThread->space->RestoreState();
+  }
+}
+
+//----------------------------------------------------------------------
+// CPUSet::Print
+// 	Print how busy each core was, and how much it stole.
+//----------------------------------------------------------------------
+
+void CPUSet::Print() {
+  for (int i = 0; i < numCPUs; i++) {
+    CPU *cpu = cpus[i];
+    int idle = kernel->stats->totalTicks - cpu->busyTicks;
+
+    cout << "CPU " << i << ": busy " << cpu->busyTicks << ", idle "
+         << ((idle > 0) ? idle : 0) << ", steals " << cpu->steals << "\n";
+  }
+}
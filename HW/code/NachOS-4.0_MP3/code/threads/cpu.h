@@ -0,0 +1,100 @@
+// cpu.h
+//	Data structures for simulating a machine with several cores.
+//
+//	With "-ncpu N", the kernel runs N simulated cores.  Each core has
+//	its own user registers (see Machine::SetCPU), its own running
+//	thread and its own ready queue.  A core that runs out of work
+//	steals a ready thread from the core with the most of them.
+//
+//	The cores are interleaved on the one host thread.  The active
+//	core runs until its own clock is CPUQuantum ticks past the
+//	global clock (stats->totalTicks), then the next core with work
+//	gets a turn; once every such core has had its quantum, the
+//	global clock moves on by CPUQuantum.  So N busy cores do N
+//	quanta of work per quantum of simulated time.
+//
+//	Cores only change on a clock tick, while the tick is being
+//	processed with interrupts disabled -- never inside code that
+//	turned interrupts off.  Disabling interrupts therefore still
+//	makes kernel code atomic with respect to every core, and the
+//	synchronization primitives and the scheduler work unchanged.
+//
+//	kernel->currentThread and kernel->scheduler always refer to the
+//	active core.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "copyright.h"
+#include "machine.h"
+#include "scheduler.h"
+#include "stats.h"
+
+// How far, in ticks, a core may run ahead of the global clock before
+// the next core gets a turn.  It must be at least SystemTick, the
+// largest step of a core's clock.
+
+const int CPUQuantum = 2 * SystemTick;
+
+// The following class defines the state of one simulated core.
+
+class CPU {
+public:
+  CPU(int cpuID, Scheduler *sched);
+
+  int id;               // index in the CPUSet, and register set
+  Scheduler *scheduler; // this core's ready queue
+  Thread *current;      // thread running on this core, saved
+                        // while another core is active
+  Thread *idleThread;   // runs when there is nothing else to;
+                        // never on a ready queue
+  int ticks;            // this core's clock
+  bool resched;         // a timer interrupt asked the running
+                        // thread to yield
+
+  int busyTicks; // ticks spent running threads
+  int steals;    // threads taken from other cores
+};
+
+// The following class defines the set of cores, and how they take
+// turns.
+
+class CPUSet {
+public:
+  CPUSet(int n, SchedPolicy policy, Quanta *quanta);
+  // core 0 takes over the running thread and kernel->scheduler
+  ~CPUSet();
+
+  int NumCPUs() { return numCPUs; }
+  CPU *Current() { return active; } // the active core
+
+  void Tick(int ticks); // the active core's clock advanced;
+                        // maybe let another core run
+  void PreemptAll();    // the timer fired: every core should
+                        // yield at its next tick
+  bool TakeResched();   // should the active core yield now?
+  void AgeOthers();     // age the ready threads of the other cores
+
+  Thread *Steal(); // dequeue a ready thread of another
+                   // core, NULL if there is none
+  Thread *IdleThread() { return active->idleThread; }
+  void WaitForWork(); // called by an idle core: run another
+                      // core, or wait for an interrupt
+
+  void Print(); // print per-core statistics
+
+private:
+  bool HasWork(CPU *cpu); // should "cpu" get a turn?
+  CPU *NextCPU();         // the core to run next, NULL if none
+  void Switch(CPU *next); // make "next" the active core
+
+  int numCPUs;
+  CPU *cpus[MaxCPUs];
+  CPU *active;
+};
+
+#endif // CPU_H
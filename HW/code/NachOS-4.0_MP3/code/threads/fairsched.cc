@@ -0,0 +1,283 @@
+// fairsched.cc
+//	Routines for the fair-share scheduling class.
+//
+//	The thread holding the CPU is charged for the ticks it uses:
+//	its virtual runtime grows by (ticks * NiceZeroWeight / weight),
+//	so heavier threads age more slowly and get picked more often.
+//	The running thread is not in the tree; it is charged on every
+//	time slice (Tick) and when it gives up the CPU (PickNext).
+//
+//	A thread that was blocked comes back with its virtual runtime
+//	raised to just under minVruntime: it does not get to monopolize
+//	the CPU to "catch up" on the time it slept, but an I/O-bound
+//	thread still runs ahead of the CPU-bound ones.
+//
+// 	These routines assume that interrupts are already disabled.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "fairsched.h"
+#include "copyright.h"
+#include "debug.h"
+#include "main.h"
+
+// Weights of the 40 Linux nice levels, -20 (heaviest) .. 19.
+// Neighbouring levels differ by about 25% in CPU share.
+static const int niceToWeight[40] = {
+    88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+    9548,  7620,  6100,  4904,  3906,  3121,  2501,  1991,  1586,  1277,
+    1024,  820,   655,   526,   423,   335,   272,   215,   172,   137,
+    110,   87,    70,    56,    45,    36,    29,    23,    18,    15};
+
+//----------------------------------------------------------------------
+// Fair_compare
+// 	Order threads by virtual runtime.  The tree needs a total order,
+//	so break ties by thread ID, then by address.
+//----------------------------------------------------------------------
+
+static int Fair_compare(Thread *x, Thread *y) {
+  if (x->vruntime < y->vruntime)
+    return -1;
+  if (x->vruntime > y->vruntime)
+    return 1;
+  if (x->getID() != y->getID())
+    return (x->getID() < y->getID()) ? -1 : 1;
+  if (x != y)
+    return (x < y) ? -1 : 1;
+  return 0;
+}
+
+//----------------------------------------------------------------------
+// FairClass::FairClass
+// 	Initialize an empty ready tree.
+//----------------------------------------------------------------------
+
+FairClass::FairClass() {
+  tree = new RBTree<Thread *>(Fair_compare);
+  totalWeight = 0;
+  minVruntime = 0;
+  running = NULL;
+  lastCharge = sliceStart = 0;
+}
+
+FairClass::~FairClass() { delete tree; }
+
+//----------------------------------------------------------------------
+// FairClass::Weight
+// 	Map a MP3 priority (0..149, higher is more important) onto the
+//	nice levels: 149 gets the heaviest weight, 0 the lightest.
+//----------------------------------------------------------------------
+
+int FairClass::Weight(int priority) {
+  if (priority < 0)
+    priority = 0;
+  if (priority > 149)
+    priority = 149;
+  return niceToWeight[39 - priority * 40 / 150];
+}
+
+//----------------------------------------------------------------------
+// FairClass::Charge
+// 	Add the ticks since the last charge to the virtual runtime of
+//	the thread holding the CPU.
+//----------------------------------------------------------------------
+
+void FairClass::Charge(int now) {
+  if (running == NULL) {
+    return;
+  }
+  running->vruntime +=
+      (double)(now - lastCharge) * NiceZeroWeight / Weight(running->priority);
+  lastCharge = now;
+}
+
+//----------------------------------------------------------------------
+// FairClass::UpdateMinVruntime
+// 	minVruntime follows the smallest virtual runtime of the running
+//	and ready threads, but never goes backwards.
+//----------------------------------------------------------------------
+
+void FairClass::UpdateMinVruntime() {
+  double v;
+
+  if (running != NULL) {
+    v = running->vruntime;
+    if (!tree->IsEmpty() && tree->Min()->vruntime < v) {
+      v = tree->Min()->vruntime;
+    }
+  } else if (!tree->IsEmpty()) {
+    v = tree->Min()->vruntime;
+  } else {
+    return;
+  }
+  if (v > minVruntime) {
+    minVruntime = v;
+  }
+}
+
+//----------------------------------------------------------------------
+// FairClass::Slice
+// 	The thread's share of the scheduling period, in ticks.  The
+//	period is FairLatency, stretched so that nobody's slice drops
+//	below FairMinGranularity.
+//----------------------------------------------------------------------
+
+int FairClass::Slice(Thread *thread) {
+  int weight = Weight(thread->priority);
+  int nr = tree->NumInTree() + 1;
+  int period = FairLatency;
+
+  if (nr * FairMinGranularity > period) {
+    period = nr * FairMinGranularity;
+  }
+  return (int)((double)period * weight / (totalWeight + weight));
+}
+
+//----------------------------------------------------------------------
+// FairClass::Enqueue
+// 	Put a ready thread in the tree.  New threads start at
+//	minVruntime; waking threads get at most half a period of
+//	credit for the time they slept; preempted threads keep their
+//	virtual runtime, as do threads that are only being requeued.
+//
+//	The thread's priority must not change while it is in the tree;
+//	see Scheduler::SetPriority.
+//----------------------------------------------------------------------
+
+void FairClass::Enqueue(Thread *thread, ThreadStatus from) {
+  double floor = minVruntime;
+
+  if (from == BLOCKED) {
+    floor -= (double)FairLatency / 2;
+  }
+  if ((from == JUST_CREATED || from == BLOCKED) && thread->vruntime < floor) {
+    thread->vruntime = floor;
+  }
+  tree->Insert(thread);
+  totalWeight += Weight(thread->priority);
+
+  DEBUG(dbgZ, "[F] Tick [" << kernel->stats->totalTicks << "]: Thread ["
+                           << thread->getID() << "] is inserted, vruntime ["
+                           << thread->vruntime << "]");
+}
+
+//----------------------------------------------------------------------
+// FairClass::PickNext
+// 	Charge the thread giving up the CPU, then dequeue the ready
+//	thread with the smallest virtual runtime.
+//
+//	When the outgoing thread is blocking (as opposed to yielding)
+//	stop charging it, so idle time is charged to nobody.
+//----------------------------------------------------------------------
+
+Thread *FairClass::PickNext() {
+  int now = kernel->stats->totalTicks;
+  Thread *next;
+
+  Charge(now);
+  if (running != NULL && running->getStatus() != RUNNING) {
+    running = NULL;
+  }
+  if (tree->IsEmpty()) {
+    return NULL;
+  }
+
+  next = tree->RemoveMin();
+  totalWeight -= Weight(next->priority);
+  running = next;
+  lastCharge = sliceStart = now;
+  UpdateMinVruntime();
+
+  DEBUG(dbgZ, "[F] Tick [" << now << "]: Thread [" << next->getID()
+                           << "] is picked, vruntime [" << next->vruntime
+                           << "], slice [" << Slice(next) << "]");
+  return next;
+}
+
+//----------------------------------------------------------------------
+// FairClass::Remove
+// 	Take a ready thread out of the tree.
+//----------------------------------------------------------------------
+
+void FairClass::Remove(Thread *thread) {
+  bool found = tree->Remove(thread);
+
+  ASSERT(found);
+  totalWeight -= Weight(thread->priority);
+}
+
+//----------------------------------------------------------------------
+// FairClass::Detach, FairClass::Attach
+// 	Move a ready thread between the trees of two cores.  Virtual
+//	runtimes are only comparable within one tree, so the thread
+//	leaves with its lead over this tree's minVruntime and gets the
+//	same lead over the other's.
+//----------------------------------------------------------------------
+
+Thread *FairClass::Detach() {
+  Thread *thread;
+
+  if (tree->IsEmpty()) {
+    return NULL;
+  }
+  thread = tree->RemoveMin();
+  totalWeight -= Weight(thread->priority);
+  thread->vruntime -= minVruntime;
+  return thread;
+}
+
+void FairClass::Attach(Thread *thread) {
+  thread->vruntime += minVruntime;
+  Enqueue(thread, READY);
+}
+
+//----------------------------------------------------------------------
+// FairClass::Tick
+// 	Charge the running thread for the time slice that just ended.
+//----------------------------------------------------------------------
+
+void FairClass::Tick() {
+  int now = kernel->stats->totalTicks;
+
+  if (running == NULL) { // e.g. "main", which never went
+                         // through PickNext
+    running = kernel->currentThread;
+    lastCharge = sliceStart = now;
+  }
+  Charge(now);
+  UpdateMinVruntime();
+}
+
+//----------------------------------------------------------------------
+// FairClass::ShouldYield
+// 	Preempt the running thread once it has used up its slice, or
+//	once it is more than a slice ahead of the leftmost ready thread.
+//	Never preempt before FairMinGranularity.
+//----------------------------------------------------------------------
+
+bool FairClass::ShouldYield(Thread *current) {
+  int ran = kernel->stats->totalTicks - sliceStart;
+  int slice;
+
+  if (tree->IsEmpty()) {
+    return FALSE;
+  }
+  ASSERT(current == running);
+  slice = Slice(current);
+  if (ran >= slice) {
+    return TRUE;
+  }
+  if (ran < FairMinGranularity) {
+    return FALSE;
+  }
+  return (current->vruntime - tree->Min()->vruntime) > slice;
+}
+
+//----------------------------------------------------------------------
+// FairClass::Print
+// 	Print the ready threads, in the order they would run.
+//----------------------------------------------------------------------
+
+void FairClass::Print() { tree->Apply(ThreadPrint); }
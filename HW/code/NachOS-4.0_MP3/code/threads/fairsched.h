@@ -0,0 +1,73 @@
+// fairsched.h
+//	Data structures for a fair-share scheduling class, in the style
+//	of the Linux "Completely Fair Scheduler".
+//
+//	Every thread accumulates a virtual runtime: the CPU time it has
+//	used, scaled down by its weight.  The ready thread with the
+//	smallest virtual runtime runs next, so over time each thread
+//	gets a share of the CPU proportional to its weight.  Ready
+//	threads are kept in a red-black tree keyed by virtual runtime,
+//	so picking the next thread is O(log n).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FAIRSCHED_H
+#define FAIRSCHED_H
+
+#include "copyright.h"
+#include "rbtree.h"
+#include "scheduler.h"
+#include "stats.h"
+
+// Weight of a thread of average priority; a thread of this weight
+// has its virtual runtime advance at the same rate as real time.
+const int NiceZeroWeight = 1024;
+
+// Period in which every ready thread should run once, and the
+// shortest slice a thread is given, in ticks.
+const int FairLatency = 6 * TimerTicks;
+const int FairMinGranularity = TimerTicks;
+
+// The following class defines the fair scheduling class.
+
+class FairClass : public SchedClass {
+public:
+  FairClass();
+  ~FairClass();
+
+  const char *getName() { return "fair"; }
+  void Enqueue(Thread *thread, ThreadStatus from);
+  Thread *PickNext();
+  void Remove(Thread *thread);
+  bool IsEmpty() { return tree->IsEmpty(); }
+  int NumReady() { return tree->NumInTree(); }
+  Thread *Detach();
+  void Attach(Thread *thread);
+  int QueueLevel(Thread *thread) { return 1; } // a single queue
+  void Tick();
+  bool ShouldYield(Thread *current);
+  void Print();
+
+  static int Weight(int priority); // map a priority (0..149) to
+                                   // a weight
+
+private:
+  void Charge(int now);     // add the running thread's CPU time
+                            // to its virtual runtime
+  void UpdateMinVruntime(); // advance minVruntime
+  int Slice(Thread *thread); // length of thread's time slice
+
+  RBTree<Thread *> *tree; // ready threads, by virtual runtime
+  int totalWeight;        // sum of the weights in tree
+  double minVruntime;     // monotonic floor of the virtual
+                          // runtimes; new and waking threads
+                          // are placed relative to it
+  Thread *running;        // thread we are charging for the CPU,
+                          // NULL while idle
+  int lastCharge;         // when "running" was last charged
+  int sliceStart;         // when "running" was picked
+};
+
+#endif // FAIRSCHED_H
@@ -10,7 +10,9 @@
 #include "debug.h"
 #include "libtest.h"
 #include "main.h"
+#include "pagecache.h"
 #include "post.h"
+#include "proctable.h"
 #include "string.h"
 #include "synch.h"
 #include "synchconsole.h"
@@ -26,15 +28,28 @@
 
 Kernel::Kernel(int argc, char **argv) {
   randomSlice = FALSE;
+  tickless = FALSE;
+  schedPolicy = MultilevelPolicy;
+  numCPUs = 1;
+  batchJobs = 0;
   debugUserProg = FALSE;
-  consoleIn = NULL;  // default is stdin
-  consoleOut = NULL; // default is stdout
+  consoleIn = NULL;       // default is stdin
+  consoleOut = NULL;      // default is stdout
+  schedFile = NULL;       // no CSV dump
+  predictorKind = "ewma"; // the MP3 predictor,
+  predictorArg = "0.5";   // ti = 0.5 * T + 0.5 * ti-1
 #ifndef FILESYS_STUB
   formatFlag = FALSE;
 #endif
   reliability = 1; // network reliability, default is 1.0
   hostName = 0;    // machine id, also UNIX socket name
                    // 0 is the default machine id
+  superPages = 1;
+#ifdef USE_TLB
+  tlbPolicy = TLBFifo;
+#else
+  tlbPolicy = TLBOff; // linear page table
+#endif
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "-rs") == 0) {
       ASSERT(i + 1 < argc);
@@ -44,6 +59,68 @@ Kernel::Kernel(int argc, char **argv) {
       i++;
     } else if (strcmp(argv[i], "-s") == 0) {
       debugUserProg = TRUE;
+    } else if (strcmp(argv[i], "-sched") == 0) {
+      ASSERT(i + 1 < argc);
+      if (strcmp(argv[i + 1], "fair") == 0) {
+        schedPolicy = FairPolicy;
+      } else {
+        ASSERT(strcmp(argv[i + 1], "multilevel") == 0);
+        schedPolicy = MultilevelPolicy;
+      }
+      i++;
+    } else if (strcmp(argv[i], "-tickless") == 0) {
+      tickless = TRUE;
+    } else if (strcmp(argv[i], "-quantum") == 0) {
+      ASSERT(i + NumSchedLevels < argc);
+      for (int l = 0; l < NumSchedLevels; l++) {
+        quanta.level[l] = atoi(argv[++i]);
+        ASSERT(quanta.level[l] >= 0);
+      }
+    } else if (strcmp(argv[i], "-aq") == 0) {
+      quanta.adaptive = TRUE;
+    } else if (strcmp(argv[i], "-sp") == 0) {
+      ASSERT(i + 1 < argc);
+      superPages = atoi(argv[i + 1]);
+      ASSERT(superPages >= 1 && superPages <= MaxSuperPage &&
+             (superPages & (superPages - 1)) == 0);
+      i++;
+    } else if (strcmp(argv[i], "-mem") == 0) {
+      ASSERT(i + 1 < argc);
+      NumPhysPages = atoi(argv[i + 1]);
+      ASSERT(NumPhysPages >= 1);
+      i++;
+    } else if (strcmp(argv[i], "-ps") == 0) {
+      ASSERT(i + 1 < argc);
+      PageSize = atoi(argv[i + 1]);
+      ASSERT(PageSize >= 4 && // whole words: none straddles two pages
+             (PageSize & (PageSize - 1)) == 0);
+      i++;
+    } else if (strcmp(argv[i], "-tlbsize") == 0) {
+      ASSERT(i + 1 < argc);
+      TLBSize = atoi(argv[i + 1]);
+      ASSERT(TLBSize >= 1);
+      i++;
+    } else if (strcmp(argv[i], "-tlb") == 0) {
+      ASSERT(i + 1 < argc);
+      if (strcmp(argv[i + 1], "random") == 0) {
+        tlbPolicy = TLBRandom;
+      } else if (strcmp(argv[i + 1], "lru") == 0) {
+        tlbPolicy = TLBLRU;
+      } else {
+        ASSERT(strcmp(argv[i + 1], "fifo") == 0);
+        tlbPolicy = TLBFifo;
+      }
+      i++;
+    } else if (strcmp(argv[i], "-ncpu") == 0) {
+      ASSERT(i + 1 < argc);
+      numCPUs = atoi(argv[i + 1]);
+      ASSERT(numCPUs >= 1 && numCPUs <= MaxCPUs);
+      i++;
+    } else if (strcmp(argv[i], "-par") == 0) {
+      ASSERT(i + 1 < argc);
+      batchJobs = atoi(argv[i + 1]);
+      ASSERT(batchJobs >= 1);
+      i++;
     } else if (strcmp(argv[i], "-e") == 0) {
       execfile[++execfileNum] = argv[++i];
       threadPriority[execfileNum] = 0; // default
@@ -51,6 +128,15 @@ Kernel::Kernel(int argc, char **argv) {
     } else if (strcmp(argv[i], "-ep") == 0) {
       execfile[++execfileNum] = argv[++i];
       threadPriority[execfileNum] = atoi(argv[++i]); // init
+    } else if (strcmp(argv[i], "-sf") == 0) {
+      ASSERT(i + 1 < argc);
+      schedFile = argv[i + 1];
+      i++;
+    } else if (strcmp(argv[i], "-bp") == 0) {
+      ASSERT(i + 2 < argc);
+      predictorKind = argv[i + 1];
+      predictorArg = argv[i + 2];
+      i += 2;
     } else if (strcmp(argv[i], "-ci") == 0) {
       ASSERT(i + 1 < argc);
       consoleIn = argv[i + 1];
@@ -74,6 +160,16 @@ Kernel::Kernel(int argc, char **argv) {
     } else if (strcmp(argv[i], "-u") == 0) {
       cout << "Partial usage: nachos [-rs randomSeed]\n";
       cout << "Partial usage: nachos [-s]\n";
+      cout << "Partial usage: nachos [-sched multilevel|fair]\n";
+      cout << "Partial usage: nachos [-quantum # # #] [-aq] [-tickless]\n";
+      cout << "Partial usage: nachos [-mem numPhysPages] [-ps pageSize]\n";
+      cout << "Partial usage: nachos [-sp superPageSize]\n";
+      cout << "Partial usage: nachos [-tlb random|fifo|lru] [-tlbsize #]\n";
+      cout << "Partial usage: nachos [-ncpu #]\n";
+      cout << "Partial usage: nachos [-par #]\n";
+      cout << "Partial usage: nachos [-sf schedStatsFile]\n";
+      cout << "Partial usage: nachos [-bp ewma alpha | median window | "
+              "history file]\n";
       cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
 #ifndef FILESYS_STUB
       cout << "Partial usage: nachos [-nf]\n";
@@ -98,19 +194,36 @@ void Kernel::Initialize() {
   currentThread = new Thread("main", threadNum++);
   currentThread->setStatus(RUNNING);
 
-  stats = new Statistics();       // collect statistics
-  interrupt = new Interrupt;      // start up interrupt handling
-  scheduler = new Scheduler();    // initialize the ready queue
-  alarm = new Alarm(randomSlice); // start up time slicing
-  machine = new Machine(debugUserProg);
+  stats = new Statistics();               // collect statistics
+  stats->schedFile = schedFile;
+  interrupt = new Interrupt;              // start up interrupt handling
+  scheduler = new Scheduler(schedPolicy, &quanta); // initialize the ready queue
+  alarm = new Alarm(randomSlice, tickless); // start up time slicing
+  if (strcmp(predictorKind, "median") == 0) {
+    predictor = new MedianPredictor(atoi(predictorArg));
+  } else if (strcmp(predictorKind, "history") == 0) {
+    predictor = new HistoryPredictor(predictorArg);
+  } else {
+    ASSERT(strcmp(predictorKind, "ewma") == 0);
+    predictor = new EWMAPredictor(atof(predictorArg));
+  }
+  machine = new Machine(debugUserProg, tlbPolicy != TLBOff);
+  AddrSpace::InitFrames(); // now that NumPhysPages is final
+  if (numCPUs > 1) {
+    cpus = new CPUSet(numCPUs, schedPolicy, &quanta); // takes over "scheduler"
+  } else {
+    cpus = NULL;
+  }
   synchConsoleIn = new SynchConsoleInput(consoleIn);    // input from stdin
   synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
   synchDisk = new SynchDisk();                          //
+  pageCache = new PageCache(); // before the file system writes to files
 #ifdef FILESYS_STUB
   fileSystem = new FileSystem();
 #else
   fileSystem = new FileSystem(formatFlag);
 #endif // FILESYS_STUB
+  processes = new ProcessTable();
   // postOfficeIn = new PostOfficeInput(10);
   // postOfficeOut = new PostOfficeOutput(reliability);
 
@@ -123,15 +236,20 @@ void Kernel::Initialize() {
 //----------------------------------------------------------------------
 
 Kernel::~Kernel() {
+  delete cpus;
   delete stats;
   delete interrupt;
   delete scheduler;
+  delete predictor; // may save its history
   delete alarm;
   delete machine;
   delete synchConsoleIn;
   delete synchConsoleOut;
   delete synchDisk;
   delete fileSystem;
+  delete processes;
+  delete pageCache;
+  AddrSpace::DeleteFrames();
   // delete postOfficeIn;
   // delete postOfficeOut;
 
@@ -140,11 +258,14 @@ Kernel::~Kernel() {
 
 //----------------------------------------------------------------------
 // Kernel::ThreadSelfTest
-//      Test threads, semaphores, synchlists
+//      Test threads, semaphores, reader-writer and sequence locks,
+//      synchlists
 //----------------------------------------------------------------------
 
 void Kernel::ThreadSelfTest() {
   Semaphore *semaphore;
+  RWLock *rwLock;
+  SeqLock *seqLock;
   SynchList<int> *synchList;
 
   LibSelfTest(); // test library routines
@@ -156,6 +277,14 @@ void Kernel::ThreadSelfTest() {
   semaphore->SelfTest();
   delete semaphore;
 
+  // test reader-writer and sequence locks
+  rwLock = new RWLock("test");
+  rwLock->SelfTest();
+  delete rwLock;
+  seqLock = new SeqLock("test");
+  seqLock->SelfTest();
+  delete seqLock;
+
   // test locks, condition variables
   // using synchronized lists
   synchList = new SynchList<int>;
@@ -252,6 +381,9 @@ void ForkExecute(Thread *t) {
 }
 
 void Kernel::ExecAll() {
+  if (batchJobs > 0 && execfileNum > 1) {
+    ExecBatch(); // never returns
+  }
   for (int i = 1; i <= execfileNum; i++) {
     int a = Exec(execfile[i], threadPriority[i]);
   }
@@ -259,13 +391,99 @@ void Kernel::ExecAll() {
   // Kernel::Exec();
 }
 
-int Kernel::Exec(char *name, int initialPriority) {
-  t[threadNum] = new Thread(name, threadNum, initialPriority);
-  t[threadNum]->space = new AddrSpace();
-  t[threadNum]->Fork((VoidFunctionPtr)&ForkExecute, (void *)t[threadNum]);
+//----------------------------------------------------------------------
+// Kernel::ExecBatch
+//      Run each user program in a copy of Nachos of its own -- a host
+//      process forked from this one -- at most batchJobs at a time, so
+//      a batch of test programs uses as many host cores.  The programs
+//      share nothing (each loads from the host file system, with
+//      FILESYS_STUB), so there is no need to interleave them on one
+//      simulated machine: each copy runs its program alone, on its own
+//      deterministic clock, and at halt sends its counters back
+//      through a pipe instead of printing them.  We add them up and
+//      halt.
+//----------------------------------------------------------------------
+
+void Kernel::ExecBatch() {
+  int pid[10], fd[10];
+  int started = 0, finished = 0;
+
+  while (finished < execfileNum) {
+    if (started < execfileNum && started - finished < batchJobs) {
+      int fds[2];
+      int i = ++started;
+
+      OpenPipe(fds);
+      cout.flush(); // or the copy prints it again
+      pid[i] = ForkProcess();
+      if (pid[i] == 0) { // the copy: run just program i
+        Close(fds[0]);
+        stats->reportFd = fds[1];
+        Exec(execfile[i], threadPriority[i]);
+        currentThread->Finish();
+        ASSERTNOTREACHED();
+      }
+      Close(fds[1]);
+      fd[i] = fds[0];
+    } else {
+      int exitCode;
+      int done = WaitProcess(&exitCode);
+
+      for (int i = 1; i <= started; i++) {
+        if (pid[i] == done) {
+          int ticks = stats->AddReport(fd[i]);
+          if (ticks >= 0) {
+            predictor->AddHistory(fd[i]); // saved at our halt
+          }
+          Close(fd[i]);
+          if (ticks >= 0 && exitCode == 0) {
+            cout << "Batch: " << execfile[i] << " done, ticks " << ticks
+                 << "\n";
+          } else {
+            cout << "Batch: " << execfile[i] << " failed, exit code "
+                 << exitCode << "\n";
+          }
+        }
+      }
+      finished++;
+    }
+  }
+  interrupt->Halt();
+}
+
+//----------------------------------------------------------------------
+// Kernel::Exec
+//      Start user program "name" in a new process, with main() called
+//      with "argc" and "argv" if there are any.  Return its SpaceId,
+//      for Join, or -1 if there are too many processes.  Only the
+//      user program calling Exec, if any, may join the new one.
+//----------------------------------------------------------------------
+
+int Kernel::Exec(char *name, int initialPriority, int argc, char **argv) {
+  Thread *thread;
+  AddrSpace *space;
+  AddrSpace *parent = currentThread->space;
+  int id = processes->Add(parent != NULL ? parent->pid : 0);
+
+  if (id < 0) {
+    return -1;
+  }
+  thread = new Thread(name, threadNum, initialPriority);
+  if (threadNum < 10) {
+    t[threadNum] = thread;
+  }
   threadNum++;
+  predictor->Seed(thread);
+  space = new AddrSpace();
+  space->pid = id;
+  space->numThreads = 1;
+  if (argc > 0) {
+    space->SetArguments(argc, argv);
+  }
+  thread->space = space;
+  thread->Fork((VoidFunctionPtr)&ForkExecute, (void *)thread);
 
-  return threadNum - 1;
+  return id;
   /*
       cout << "Total threads number is " << execfileNum << endl;
       for (int n=1;n<=execfileNum;n++) {
@@ -10,16 +10,20 @@
 
 #include "alarm.h"
 #include "copyright.h"
+#include "cpu.h"
 #include "debug.h"
 #include "filesys.h"
 #include "interrupt.h"
 #include "machine.h"
+#include "predictor.h"
 #include "scheduler.h"
 #include "stats.h"
 #include "thread.h"
 #include "utility.h"
 
+class PageCache;
 class PostOfficeInput;
+class ProcessTable;
 class PostOfficeOutput;
 class SynchConsoleInput;
 class SynchConsoleOutput;
@@ -37,12 +41,15 @@ public:
                      // from constructor because
                      // refers to "kernel" as a global
   void ExecAll();
-  int Exec(char *name, int initialPriority);
+  void ExecBatch(); // ExecAll, one host process per program
+  int Exec(char *name, int initialPriority, int argc = 0,
+           char **argv = NULL); // start a process; return its SpaceId
   void ThreadSelfTest(); // self test of threads and synchronization
 
   void ConsoleTest(); // interactive console self test
   void NetworkTest(); // interactive 2-machine network test
   Thread *getThread(int threadID) { return t[threadID]; }
+  int NewThreadID() { return threadNum++; } // for threads not Exec'ed
 
   void PrintInt(int number);
   int CreateFile(char *filename); // fileSystem call
@@ -55,20 +62,26 @@ public:
   // These are public for notational convenience; really,
   // they're global variables used everywhere.
 
-  Thread *currentThread; // the thread holding the CPU
-  Scheduler *scheduler;  // the ready list
-  Interrupt *interrupt;  // interrupt status
-  Statistics *stats;     // performance metrics
-  Alarm *alarm;          // the software alarm clock
-  Machine *machine;      // the simulated CPU
+  Thread *currentThread;     // the thread holding the CPU
+  Scheduler *scheduler;      // the ready list
+  BurstPredictor *predictor; // guesses the next CPU burst
+  Interrupt *interrupt;      // interrupt status
+  Statistics *stats;         // performance metrics
+  Alarm *alarm;              // the software alarm clock
+  Machine *machine;          // the simulated CPU
+  CPUSet *cpus;              // its cores, NULL if just one
   SynchConsoleInput *synchConsoleIn;
   SynchConsoleOutput *synchConsoleOut;
   SynchDisk *synchDisk;
   FileSystem *fileSystem;
+  ProcessTable *processes; // for Exec and Join
+  PageCache *pageCache;    // program pages, shared by processes
   PostOfficeInput *postOfficeIn;
   PostOfficeOutput *postOfficeOut;
 
-  int hostName; // machine identifier
+  int hostName;   // machine identifier
+  int superPages; // base pages per superpage (-sp), 1 if none
+  TLBPolicy tlbPolicy; // how to replace TLB entries, or TLBOff
 
 private:
   Thread *t[10];
@@ -76,11 +89,20 @@ private:
   int threadPriority[10];
   int execfileNum;
   int threadNum;
-  bool randomSlice;   // enable pseudo-random time slicing
-  bool debugUserProg; // single step user program
-  double reliability; // likelihood messages are dropped
-  char *consoleIn;    // file to read console input from
-  char *consoleOut;   // file to send console output to
+  bool randomSlice;        // enable pseudo-random time slicing
+  bool tickless;           // stop the timer while it has nothing to do
+  SchedPolicy schedPolicy; // which scheduling class to use
+  Quanta quanta;           // its time slices
+  int numCPUs;             // number of simulated cores
+  int batchJobs;           // if > 0, run the programs in separate
+                           // host processes, this many at a time
+  bool debugUserProg;      // single step user program
+  double reliability;      // likelihood messages are dropped
+  char *consoleIn;         // file to read console input from
+  char *consoleOut;        // file to send console output to
+  char *schedFile;         // file to dump scheduling statistics to
+  char *predictorKind;     // "ewma", "median" or "history"
+  char *predictorArg;      // its alpha, window or history file
 #ifndef FILESYS_STUB
   bool formatFlag; // format the disk if this is true
 #endif
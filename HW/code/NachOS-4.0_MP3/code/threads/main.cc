@@ -4,6 +4,11 @@
 //
 // Usage: nachos -d <debugflags> -rs <random seed #>
 //              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
+//              -sched <multilevel|fair> -sf <sched stats file> -ncpu <#>
+//              -quantum <L1> <L2> <L3> -aq -tickless
+//              -par <#>
+//              -mem <#> -ps <#> -sp <#> -tlb <policy> -tlbsize <#>
+//              -bp <predictor> <arg>
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D
 //              -n <network reliability> -m <machine id>
@@ -13,6 +18,22 @@
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
 //    -s causes user programs to be executed in single-step mode
+//    -sched selects the scheduling policy, "multilevel" (default) or "fair"
+//    -sf writes the scheduling statistics to a file, as CSV, at halt
+//    -quantum sets the time slice of each ready queue level, in ticks;
+//	0 keeps the level's usual rule (see scheduler.h)
+//    -aq adapts each thread's time slice to how it uses the CPU
+//    -tickless only runs the timer while threads wait in the ready queue
+//    -ncpu simulates a machine with that many cores (see cpu.h)
+//    -mem sets the number of pages of physical memory (default 128)
+//    -ps sets the page size, in bytes (default 128)
+//    -sp maps that many pages with one TLB entry where it can
+//    -tlb runs the machine with a TLB, replacing entries "random",
+//	"fifo" or "lru"; -tlbsize sets its number of entries (default 4)
+//    -par runs each -e program in its own host process, that many at
+//	a time, and adds up their statistics (see Kernel::ExecBatch)
+//    -bp selects the CPU burst predictor: "ewma <alpha>" (default 0.5),
+//	"median <window>" or "history <file>"
 //    -x runs a user program
 //    -ci specify file for console input (stdin is the default)
 //    -co specify file for console output (stdout is the default)
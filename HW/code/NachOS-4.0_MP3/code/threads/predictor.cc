@@ -0,0 +1,224 @@
+// predictor.cc
+//	Routines for the CPU burst predictors used by the L1 queue.
+//
+//	All predictors see only the thread and the length of its last
+//	burst; the per-thread state they need (the previous prediction,
+//	the recent bursts) is kept in the thread itself.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "predictor.h"
+#include "copyright.h"
+#include "debug.h"
+#include "sysdep.h"
+
+//----------------------------------------------------------------------
+// EWMAPredictor::EWMAPredictor
+//	"a" is the weight of the newest burst.
+//----------------------------------------------------------------------
+
+EWMAPredictor::EWMAPredictor(double a) {
+  ASSERT(a >= 0 && a <= 1);
+  alpha = a;
+}
+
+double EWMAPredictor::Update(Thread *thread, int burst) {
+  return alpha * burst + (1 - alpha) * thread->last_ti;
+}
+
+//----------------------------------------------------------------------
+// MedianPredictor::MedianPredictor
+//	"w" is the number of recent bursts to take the median of.
+//----------------------------------------------------------------------
+
+MedianPredictor::MedianPredictor(int w) {
+  ASSERT(w >= 1 && w <= MaxBurstWindow);
+  window = w;
+}
+
+//----------------------------------------------------------------------
+// MedianPredictor::Update
+//	Remember the burst in the thread's ring of recent bursts, and
+//	return the median of the ones we have (at most "window").
+//----------------------------------------------------------------------
+
+double MedianPredictor::Update(Thread *thread, int burst) {
+  int sorted[MaxBurstWindow];
+  int n, i, j;
+
+  thread->recentBursts[thread->numBursts % window] = burst;
+  thread->numBursts++;
+  n = (thread->numBursts < window) ? thread->numBursts : window;
+
+  for (i = 0; i < n; i++) { // insertion sort, n is tiny
+    int b = thread->recentBursts[i];
+    for (j = i; j > 0 && sorted[j - 1] > b; j--) {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = b;
+  }
+  if (n % 2 == 1) {
+    return sorted[n / 2];
+  }
+  return 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+}
+
+//----------------------------------------------------------------------
+// HistoryPredictor::HistoryPredictor
+//	Load the per-executable history from "file", if it exists.
+//----------------------------------------------------------------------
+
+HistoryPredictor::HistoryPredictor(char *file) {
+  fileName = file;
+  save = TRUE;
+  ewma = new EWMAPredictor(0.5);
+  numEntries = 0;
+  Load();
+}
+
+HistoryPredictor::~HistoryPredictor() {
+  if (save) {
+    Save();
+  }
+  delete ewma;
+}
+
+//----------------------------------------------------------------------
+// HistoryPredictor::Find
+//	Linear search; the table holds one entry per executable.
+//	If "create", add a (zero) entry for a new name, if there's room.
+//----------------------------------------------------------------------
+
+int HistoryPredictor::Find(char *name, bool create) {
+  for (int i = 0; i < numEntries; i++) {
+    if (strcmp(names[i], name) == 0) {
+      return i;
+    }
+  }
+  if (!create || numEntries == MaxHistoryEntries ||
+      strlen(name) >= MaxHistoryName) {
+    return -1;
+  }
+  strcpy(names[numEntries], name);
+  predictions[numEntries] = 0;
+  return numEntries++;
+}
+
+//----------------------------------------------------------------------
+// HistoryPredictor::Seed
+//	Start a thread from the last prediction for its executable.
+//----------------------------------------------------------------------
+
+void HistoryPredictor::Seed(Thread *thread) {
+  int i = Find(thread->getName(), FALSE);
+
+  if (i >= 0) {
+    thread->ti = thread->last_ti = predictions[i];
+    DEBUG(dbgThread, "Seeding " << thread->getName() << " with ti "
+                                << thread->ti);
+  }
+}
+
+double HistoryPredictor::Update(Thread *thread, int burst) {
+  double ti = ewma->Update(thread, burst);
+  int i = Find(thread->getName(), TRUE);
+
+  if (i >= 0) {
+    predictions[i] = ti;
+  }
+  return ti;
+}
+
+//----------------------------------------------------------------------
+// HistoryPredictor::Load, HistoryPredictor::Save
+//	Read/write the history file, one "name prediction" per line.
+//	A missing or unreadable file just means no history.
+//----------------------------------------------------------------------
+
+void HistoryPredictor::Load() {
+  int fd = OpenForReadWrite(fileName, FALSE);
+  char *buffer, *line, *next;
+  int size;
+
+  if (fd < 0) {
+    return;
+  }
+  buffer = new char[MaxHistoryEntries * (MaxHistoryName + 32)];
+  size = ReadPartial(fd, buffer, MaxHistoryEntries * (MaxHistoryName + 32) - 1);
+  Close(fd);
+  if (size < 0) {
+    size = 0;
+  }
+  buffer[size] = '\0';
+
+  for (line = buffer; *line != '\0'; line = next) {
+    char name[MaxHistoryName];
+    double ti;
+    int i;
+
+    next = strchr(line, '\n');
+    if (next != NULL) {
+      *next++ = '\0';
+    } else {
+      next = line + strlen(line);
+    }
+    if (sscanf(line, "%63s %lf", name, &ti) == 2 &&
+        (i = Find(name, TRUE)) >= 0) {
+      predictions[i] = ti;
+    }
+  }
+  delete[] buffer;
+}
+
+void HistoryPredictor::Save() {
+  int fd = OpenForWrite(fileName);
+  char line[MaxHistoryName + 32];
+
+  for (int i = 0; i < numEntries; i++) {
+    sprintf(line, "%s %.2f\n", names[i], predictions[i]);
+    WriteFile(fd, line, strlen(line));
+  }
+  Close(fd);
+}
+
+//----------------------------------------------------------------------
+// HistoryPredictor::SendHistory, HistoryPredictor::AddHistory
+//	A batch copy of Nachos (see Kernel::ExecBatch) sends its table
+//	to the parent through the report pipe, after the counters, and
+//	leaves the file alone; the parent merges the tables of all its
+//	copies, and saves the file once, at its own halt.  Each entry is
+//	a fixed-size record, name then prediction.
+//----------------------------------------------------------------------
+
+void HistoryPredictor::SendHistory(int fd) {
+  WriteFile(fd, (char *)&numEntries, sizeof(int));
+  for (int i = 0; i < numEntries; i++) {
+    WriteFile(fd, names[i], MaxHistoryName);
+    WriteFile(fd, (char *)&predictions[i], sizeof(double));
+  }
+  save = FALSE;
+}
+
+void HistoryPredictor::AddHistory(int fd) {
+  int count;
+
+  if (ReadPartial(fd, (char *)&count, sizeof(int)) != sizeof(int)) {
+    return; // it died before sending any
+  }
+  for (int n = 0; n < count; n++) {
+    char name[MaxHistoryName];
+    double ti;
+    int i;
+
+    if (ReadPartial(fd, name, MaxHistoryName) != MaxHistoryName ||
+        ReadPartial(fd, (char *)&ti, sizeof(double)) != sizeof(double)) {
+      return;
+    }
+    name[MaxHistoryName - 1] = '\0';
+    if ((i = Find(name, TRUE)) >= 0) {
+      predictions[i] = ti;
+    }
+  }
+}
@@ -0,0 +1,103 @@
+// predictor.h
+//	Data structures for predicting the next CPU burst of a thread.
+//
+//	The L1 queue is shortest-job-first on the predicted burst "ti",
+//	so a bad prediction puts threads in the wrong order.  A burst
+//	predictor turns the length of the burst that just ended into
+//	the next prediction; which one is used is picked at startup
+//	(-bp).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PREDICTOR_H
+#define PREDICTOR_H
+
+#include "copyright.h"
+#include "thread.h"
+
+// The following class defines the interface of a burst predictor.
+
+class BurstPredictor {
+public:
+  virtual ~BurstPredictor() {}
+
+  virtual const char *getName() = 0; // for debugging
+
+  virtual void Seed(Thread *thread) {}
+  // Set the initial prediction of a
+  // thread about to run "thread->getName()"
+  virtual double Update(Thread *thread, int burst) = 0;
+  // A burst of "burst" ticks ended;
+  // return the next prediction
+  virtual void SendHistory(int fd) {}
+  // In one program of a batch run (-par):
+  // pass what was learned to the parent
+  virtual void AddHistory(int fd) {}
+  // ... and in the parent, take it in
+};
+
+// Exponential average: ti = alpha * burst + (1 - alpha) * ti-1.
+// With alpha 0.5 this is the original MP3 predictor.
+
+class EWMAPredictor : public BurstPredictor {
+public:
+  EWMAPredictor(double a);
+
+  const char *getName() { return "ewma"; }
+  double Update(Thread *thread, int burst);
+
+private:
+  double alpha; // weight of the newest burst, 0..1
+};
+
+// Median of the last "window" bursts; ignores one-off outliers that
+// would drag an average around.
+
+class MedianPredictor : public BurstPredictor {
+public:
+  MedianPredictor(int w);
+
+  const char *getName() { return "median"; }
+  double Update(Thread *thread, int burst);
+
+private:
+  int window; // 1..MaxBurstWindow
+};
+
+// Exponential average, seeded from what the same executable did last
+// time.  The final prediction per executable is kept in a text file
+// ("name prediction" per line), read at startup and written back when
+// the predictor is deleted at halt.  In a batch run, only the parent
+// Nachos writes it, with what each program learned merged in.
+
+const int MaxHistoryEntries = 64;
+const int MaxHistoryName = 64;
+
+class HistoryPredictor : public BurstPredictor {
+public:
+  HistoryPredictor(char *file);
+  ~HistoryPredictor(); // saves the history file
+
+  const char *getName() { return "history"; }
+  void Seed(Thread *thread);
+  double Update(Thread *thread, int burst);
+  void SendHistory(int fd);
+  void AddHistory(int fd);
+
+private:
+  int Find(char *name, bool create); // index of "name" in the table,
+                                     // -1 if absent
+  void Load();
+  void Save();
+
+  char *fileName;
+  bool save; // write the file back at halt? Not in a batch copy
+  EWMAPredictor *ewma;
+  int numEntries;
+  char names[MaxHistoryEntries][MaxHistoryName];
+  double predictions[MaxHistoryEntries];
+};
+
+#endif // PREDICTOR_H
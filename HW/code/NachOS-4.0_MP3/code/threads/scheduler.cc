@@ -11,8 +11,8 @@
 //	end up calling FindNextToRun(), and that would put us in an
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	The ordering policy lives in a scheduling class (see scheduler.h):
+//	MultilevelClass below, or FairClass in fairsched.cc.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -21,6 +21,7 @@
 #include "scheduler.h"
 #include "copyright.h"
 #include "debug.h"
+#include "fairsched.h"
 #include "main.h"
 
 //------------------------------
@@ -49,15 +50,28 @@ static int L2_compare(Thread *x, Thread *y) {
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads.
 //	Initially, no ready threads.
+//
+//	"policy" selects the scheduling class deciding who runs next.
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler() {
-  readyList = new List<Thread *>;
-  toBeDestroyed = NULL;
+Quanta::Quanta() {
+  for (int i = 0; i < NumSchedLevels; i++) {
+    level[i] = 0;
+  }
+  adaptive = FALSE;
+}
 
-  L1 = new SortedList<Thread *>(L1_compare);
-  L2 = new SortedList<Thread *>(L2_compare);
-  L3 = new List<Thread *>;
+Scheduler::Scheduler(SchedPolicy schedPolicy, Quanta *schedQuanta) {
+  policy = schedPolicy;
+  quanta = schedQuanta;
+  if (policy == FairPolicy) {
+    sched = new FairClass();
+  } else {
+    sched = new MultilevelClass();
+  }
+  toBeDestroyed = NULL;
+  burstOpen = TRUE; // "main" is running already
+  DEBUG(dbgThread, "Scheduling policy: " << sched->getName());
 }
 
 //----------------------------------------------------------------------
@@ -65,76 +79,362 @@ Scheduler::Scheduler() {
 // 	De-allocate the list of ready threads.
 //----------------------------------------------------------------------
 
-Scheduler::~Scheduler() {
+Scheduler::~Scheduler() { delete sched; }
 
-  delete L1;
-  delete L2;
-  delete L3;
-  delete readyList;
+//----------------------------------------------------------------------
+// Scheduler::ReadyToRun
+// 	Mark a thread as ready, but not running.
+//	Put it on the ready list, for later scheduling onto the CPU.
+//
+//	"thread" is the thread to be put on the ready list.
+//----------------------------------------------------------------------
+
+void Scheduler::ReadyToRun(Thread *thread) {
+  ThreadStatus from = thread->getStatus();
+
+  ASSERT(kernel->interrupt->getLevel() == IntOff);
+  DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
+  thread->setStatus(READY);
+  thread->set_start_wait_time(kernel->stats->totalTicks);
+  thread->enqueue_time = kernel->stats->totalTicks;
+  thread->readyOn = this;
+  sched->Enqueue(thread, from);
+  kernel->alarm->UpdateTimer();
 }
 
 //----------------------------------------------------------------------
-// Scheduler::AddToQueue
+// Scheduler::Scheduling
+// 	Return the next thread to be scheduled onto the CPU, like
+//	FindNextToRun, and start its CPU burst.
+//
+//	Also feeds the scheduling statistics: the burst of the current
+//	thread ends here if it is blocking, or if it is being replaced
+//	while still runnable (a preemption); the thread returned has
+//	finished waiting in the ready queue.
 //----------------------------------------------------------------------
-void Scheduler::AddToQueue(Thread *thread, int priority) {
-  thread->set_start_wait_time(kernel->stats->totalTicks);
 
-  if (priority >= 100) {
-    thread->setStatus(READY);
-    DEBUG(dbgZ, "[A] Tick [​ {"
-                    << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
-                    << thread->getID()
-                    << "}​ ] is inserted into queueL[​ {1}​ ]");
-    L1->Insert(thread);
-  } else if (priority >= 50) {
-    thread->setStatus(READY);
-    DEBUG(dbgZ, "[A] Tick [​ {"
+Thread *Scheduler::Scheduling() {
+  Statistics *stats = kernel->stats;
+  Thread *current = kernel->currentThread;
+  bool preempted = (current->getStatus() == RUNNING);
+  Thread *next_Thread = FindNextToRun();
+
+  if (burstOpen && (next_Thread != NULL || !preempted)) {
+    int ran = stats->totalTicks - current->CPU_start_time;
+
+    stats->RecordBurst(current->getID(), current->getName(),
+                       sched->QueueLevel(current), ran, preempted);
+    AdaptQuantum(current, ran, preempted);
+    burstOpen = FALSE;
+  }
+
+  if (next_Thread != NULL) {
+    stats->RecordWait(next_Thread->getID(), next_Thread->getName(),
+                      sched->QueueLevel(next_Thread),
+                      stats->totalTicks - next_Thread->enqueue_time);
+    burstOpen = TRUE;
+    next_Thread->record_start_time(kernel->stats->totalTicks);
+    DEBUG(dbgZ, "[E] Tick [​ {"
                     << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
-                    << thread->getID()
-                    << "}​ ] is inserted into queueL[​ {2}​ ]");
-    L2->Insert(thread);
+                    << next_Thread->getID()
+                    << "}​ ] is now selected for execution, thread [​ {"
+                    << kernel->currentThread->getID()
+                    << "}​ ] is replaced, and it has executed [​ {"
+                    << kernel->stats->totalTicks -
+                           kernel->currentThread->CPU_start_time
+                    << "}​ ] ticks ");
+  }
+  return next_Thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Tick, Scheduler::ShouldYield
+// 	Called from Thread::Yield on every time slice: let the scheduling
+//	class update its state, then ask it whether the running thread
+//	should give up the CPU.
+//
+//	With several cores, the threads waiting on the other cores'
+//	queues age too (Age); they move between levels, and maybe
+//	preempt, on their own core's next Tick.
+//----------------------------------------------------------------------
+
+void Scheduler::Tick() {
+  sched->Tick();
+  if (kernel->cpus != NULL) {
+    kernel->cpus->AgeOthers();
+  }
+}
+
+void Scheduler::Age() { sched->Age(); }
+
+//----------------------------------------------------------------------
+// Scheduler::ShouldYield
+// 	Called at every timer interrupt: should the running thread give
+//	up the CPU now?  Yes once it has used up its quantum, if it has
+//	one; otherwise ask the policy.
+//----------------------------------------------------------------------
+
+bool Scheduler::ShouldYield(Thread *current) {
+  int quantum = Quantum(current);
+
+  if (quantum == 0) {
+    return sched->ShouldYield(current);
+  }
+  return kernel->stats->totalTicks - current->CPU_start_time >= quantum;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Quantum
+// 	Return the time slice of "thread", or 0 if it is up to the
+//	policy when the thread yields.  See scheduler.h.
+//----------------------------------------------------------------------
+
+int Scheduler::Quantum(Thread *thread) {
+  int level, quantum;
+
+  if (policy != MultilevelPolicy) {
+    return 0;
+  }
+  level = sched->QueueLevel(thread);
+  quantum = quanta->level[level - 1];
+  if (!quanta->adaptive) {
+    return quantum;
+  }
+  if (quantum == 0) {
+    if (level != 3) {
+      return 0; // not time sliced at all
+    }
+    quantum = TimerTicks;
+  }
+  if (thread->quantum == 0) { // first time slice
+    thread->quantum = quantum;
+  }
+  return thread->quantum;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::AdaptQuantum
+// 	In adaptive mode, adjust the quantum of a thread that just left
+//	the CPU after running "ran" ticks.
+//----------------------------------------------------------------------
+
+void Scheduler::AdaptQuantum(Thread *thread, int ran, bool preempted) {
+  int quantum = Quantum(thread);
+
+  if (!quanta->adaptive || quantum == 0) {
+    return;
+  }
+  if (preempted && ran >= quantum && quantum < MaxQuantum) {
+    quantum *= 2; // CPU bound
+  } else if (!preempted && 2 * ran < quantum && quantum > MinQuantum) {
+    quantum /= 2; // interactive
+  }
+  if (quantum > MaxQuantum) {
+    quantum = MaxQuantum;
+  } else if (quantum < MinQuantum) {
+    quantum = MinQuantum;
+  }
+  if (quantum != thread->quantum) {
+    DEBUG(dbgThread, "Quantum of " << thread->getName() << " is now "
+                                   << quantum);
+    thread->quantum = quantum;
+  }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetPriority
+// 	Change the priority a thread is scheduled by.  A ready thread is
+//	taken out of its queue first and put back afterwards, since the
+//	queues are ordered (or, for MultilevelClass, chosen) by priority.
+//	With several cores, that is the queue of the core it is ready
+//	on, which need not be this one.
+//----------------------------------------------------------------------
+
+void Scheduler::SetPriority(Thread *thread, int priority) {
+  ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+  if (thread->priority == priority) {
+    return;
+  }
+  if (thread->getStatus() == READY) {
+    SchedClass *queue = thread->readyOn->sched;
+
+    queue->Remove(thread);
+    thread->priority = priority;
+    queue->Enqueue(thread, READY);
   } else {
-    thread->setStatus(READY);
-    DEBUG(dbgZ, "[A] Tick [​ {"
-                    << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
-                    << thread->getID()
-                    << "}​ ] is inserted into queueL[​ {3}​ ]");
-    L3->Append(thread);
+    thread->priority = priority;
   }
 }
 
 //----------------------------------------------------------------------
-// Scheduler::ReadyToRun
-// 	Mark a thread as ready, but not running.
-//	Put it on the ready list, for later scheduling onto the CPU.
+// Scheduler::FindNextToRun
+// 	Return the next thread to be scheduled onto the CPU.
+//	If there are no ready threads, steal one from another core, if
+//	there are several; failing that, return NULL.
+// Side effect:
+//	Thread is removed from the ready list.
+//----------------------------------------------------------------------
+
+Thread *Scheduler::FindNextToRun() {
+  Thread *next;
+
+  ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+  next = sched->PickNext();
+  if (next == NULL && kernel->cpus != NULL) {
+    next = kernel->cpus->Steal(); // nothing here, help a busier core
+    if (next != NULL) {
+      sched->Attach(next);
+      next = sched->PickNext();
+    }
+  }
+  return next;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Run
+// 	Dispatch the CPU to nextThread.  Save the state of the old thread,
+//	and load the state of the new thread, by calling the machine
+//	dependent context switch routine, SWITCH.
 //
-//	"thread" is the thread to be put on the ready list.
+//      Note: we assume the state of the previously running thread has
+//	already been changed from running to blocked or ready (depending).
+// Side effect:
+//	The global variable kernel->currentThread becomes nextThread.
+//
+//	"nextThread" is the thread to be put into the CPU.
+//	"finishing" is set if the current thread is to be deleted
+//		once we're no longer running on its stack
+//		(when the next thread starts running)
 //----------------------------------------------------------------------
 
-void Scheduler::ReadyToRun(Thread *thread) {
+void Scheduler::Run(Thread *nextThread, bool finishing) {
+  Thread *oldThread = kernel->currentThread;
+
   ASSERT(kernel->interrupt->getLevel() == IntOff);
-  DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
-  // cout << "Putting thread on ready list: " << thread->getName() << endl ;
-  thread->setStatus(READY);
-  //   readyList->Append(thread);
-  thread->set_start_wait_time(kernel->stats->totalTicks);
 
+  if (finishing) { // mark that we need to delete current thread
+    ASSERT(toBeDestroyed == NULL);
+    toBeDestroyed = oldThread;
+  }
+
+  if (oldThread->space != NULL) { // if this thread is a user program,
+    oldThread->SaveUserState();   // save the user's CPU registers
+    oldThread->space->SaveState();
+  }
+
+  oldThread->CheckOverflow(); // check if the old thread
+                              // had an undetected stack overflow
+
+  if (nextThread != oldThread) {
+    kernel->stats->numContextSwitches++;
+  }
+  kernel->alarm->UpdateTimer(); // nextThread left the ready queue
+  kernel->currentThread = nextThread; // switch to the next thread
+  nextThread->setStatus(RUNNING);     // nextThread is now running
+
+  DEBUG(dbgThread, "Switching from: " << oldThread->getName()
+                                      << " to: " << nextThread->getName());
+
+  // This is a machine-dependent assembly language routine defined
+  // in switch.s.  You may have to think
+  // a bit to figure out what happens after this, both from the point
+  // of view of the thread and from the perspective of the "outside world".
+
+  nextThread->ready_queue_wait_time = 0;
+
+  SWITCH(oldThread, nextThread);
+
+  // we're back, running oldThread
+
+  // interrupts are off when we return from switch!
+  ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+  DEBUG(dbgThread, "Now in thread: " << oldThread->getName());
+
+  kernel->scheduler->CheckToBeDestroyed(); // check if thread we were
+                                           // running before this one
+                                           // has finished and needs to
+                                           // be cleaned up (on a
+                                           // multi-core machine, we may
+                                           // be back on another core)
+
+  if (oldThread->space != NULL) {  // if there is an address space
+    oldThread->RestoreUserState(); // to restore, do it.
+    oldThread->space->RestoreState();
+  }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::CheckToBeDestroyed
+// 	If the old thread gave up the processor because it was finishing,
+// 	we need to delete its carcass.  Note we cannot delete the thread
+// 	before now (for example, in Thread::Finish()), because up to this
+// 	point, we were still running on the old thread's stack!
+//----------------------------------------------------------------------
+
+void Scheduler::CheckToBeDestroyed() {
+  if (toBeDestroyed != NULL) {
+    delete toBeDestroyed;
+    toBeDestroyed = NULL;
+  }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::IsEmpty
+// 	Return TRUE if no thread is waiting in any ready queue.
+//	Used by Interrupt::Idle to decide when to stop fast-forwarding.
+//----------------------------------------------------------------------
+
+bool Scheduler::IsEmpty() { return sched->IsEmpty(); }
+
+//----------------------------------------------------------------------
+// Scheduler::Print
+// 	Print the scheduler state -- in other words, the contents of
+//	the ready list.  For debugging.
+//----------------------------------------------------------------------
+void Scheduler::Print() {
+  cout << "Ready list contents (" << sched->getName() << "):\n";
+  sched->Print();
+}
+
+//----------------------------------------------------------------------
+// MultilevelClass::MultilevelClass
+// 	Initialize the three ready queues, empty to start with.
+//----------------------------------------------------------------------
+
+MultilevelClass::MultilevelClass() {
+  L1 = new SortedList<Thread *>(L1_compare);
+  L2 = new SortedList<Thread *>(L2_compare);
+  L3 = new List<Thread *>;
+}
+
+MultilevelClass::~MultilevelClass() {
+  delete L1;
+  delete L2;
+  delete L3;
+}
+
+//----------------------------------------------------------------------
+// MultilevelClass::Enqueue
+// 	Put a ready thread on the queue its priority belongs to.
+//----------------------------------------------------------------------
+
+void MultilevelClass::Enqueue(Thread *thread, ThreadStatus from) {
   if (thread->priority >= 100) {
-    // thread->setStatus(READY);
     L1->Insert(thread);
     DEBUG(dbgZ, "[A] Tick [​ {"
                     << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
                     << thread->getID()
                     << "}​ ] is inserted into queueL[​ {1}​ ]");
   } else if (thread->priority >= 50) {
-    // thread->setStatus(READY);
     L2->Insert(thread);
     DEBUG(dbgZ, "[A] Tick [​ {"
                     << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
                     << thread->getID()
                     << "}​ ] is inserted into queueL[​ {2}​ ]");
   } else {
-    // thread->setStatus(READY);
     L3->Append(thread);
     DEBUG(dbgZ, "[A] Tick [​ {"
                     << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
@@ -143,76 +443,73 @@ void Scheduler::ReadyToRun(Thread *thread) {
   }
 }
 
-//------------------------------
-// Scheduler::Scheduling
-//------------------------------
-Thread *Scheduler::Scheduling() {
+//----------------------------------------------------------------------
+// MultilevelClass::PickNext
+// 	Dequeue the front thread of the highest non-empty level.
+//----------------------------------------------------------------------
+
+Thread *MultilevelClass::PickNext() {
   Thread *next_Thread;
 
   if (!L1->IsEmpty()) {
     next_Thread = L1->RemoveFront();
-    next_Thread->record_start_time(kernel->stats->totalTicks);
     DEBUG(dbgZ, "[B] Tick [​ {"
                     << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
                     << next_Thread->getID()
                     << "}​ ] is removed from queue L[​ {1}​ ]");
-    DEBUG(dbgZ, "[E] Tick [​ {"
-                    << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
-                    << next_Thread->getID()
-                    << "}​ ] is now selected for execution, thread [​ {"
-                    << kernel->currentThread->getID()
-                    << "}​ ] is replaced, and it has executed [​ {"
-                    << kernel->stats->totalTicks -
-                           kernel->currentThread->CPU_start_time
-                    << "}​ ] ticks ");
     return next_Thread;
   }
 
   if (!L2->IsEmpty()) {
     next_Thread = L2->RemoveFront();
-    next_Thread->record_start_time(kernel->stats->totalTicks);
     DEBUG(dbgZ, "[B] Tick [​ {"
                     << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
                     << next_Thread->getID()
                     << "}​ ] is removed from queue L[​ {2}​ ]");
-    DEBUG(dbgZ, "[E] Tick [​ {"
-                    << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
-                    << next_Thread->getID()
-                    << "}​ ] is now selected for execution, thread [​ {"
-                    << kernel->currentThread->getID()
-                    << "}​ ] is replaced, and it has executed [​ {"
-                    << kernel->stats->totalTicks -
-                           kernel->currentThread->CPU_start_time
-                    << "}​ ] ticks ");
     return next_Thread;
   }
 
   if (!L3->IsEmpty()) {
     next_Thread = L3->RemoveFront();
-    next_Thread->record_start_time(kernel->stats->totalTicks);
     DEBUG(dbgZ, "[B] Tick [​ {"
                     << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
                     << next_Thread->getID()
                     << "}​ ] is removed from queue L[​ {3}​ ]");
-    DEBUG(dbgZ, "[E] Tick [​ {"
-                    << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
-                    << next_Thread->getID()
-                    << "}​ ] is now selected for execution, thread [​ {"
-                    << kernel->currentThread->getID()
-                    << "}​ ] is replaced, and it has executed [​ {"
-                    << kernel->stats->totalTicks -
-                           kernel->currentThread->CPU_start_time
-                    << "}​ ] ticks ");
     return next_Thread;
   }
 
   return NULL;
 }
 
+//----------------------------------------------------------------------
+// MultilevelClass::Remove
+// 	Take a ready thread out of whichever level holds it.
+//----------------------------------------------------------------------
+
+void MultilevelClass::Remove(Thread *thread) {
+  int level;
+
+  if (L1->IsInList(thread)) {
+    L1->Remove(thread);
+    level = 1;
+  } else if (L2->IsInList(thread)) {
+    L2->Remove(thread);
+    level = 2;
+  } else {
+    ASSERT(L3->IsInList(thread));
+    L3->Remove(thread);
+    level = 3;
+  }
+  DEBUG(dbgZ, "[B] Tick [​ {"
+                  << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
+                  << thread->getID() << "}​ ] is removed from queue L[​ {"
+                  << level << "}​ ]");
+}
+
 //------------------------------
-// Scheduler::Aging
+// MultilevelClass::Aging
 //--------------------------------
-void Scheduler::Aging() {
+void MultilevelClass::Aging() {
   Thread *thread;
   int totalTicks = kernel->stats->totalTicks;
 
@@ -234,6 +531,9 @@ void Scheduler::Aging() {
                           << iterator->Item()->priority
                           << "}​ ] to [​ {149}​ ]");
           thread->priority = 149;
+          thread->basePriority = (thread->basePriority + 10 >= 149)
+                                     ? 149
+                                     : thread->basePriority + 10;
         } else {
           DEBUG(dbgZ, "[C] Tick [​ {"
                           << kernel->stats->totalTicks
@@ -243,6 +543,7 @@ void Scheduler::Aging() {
                           << iterator->Item()->priority << "}​ ] to [​ {"
                           << iterator->Item()->priority + 10 << "}​ ]");
           thread->priority += 10;
+          thread->basePriority += 10;
         }
         thread->ready_queue_wait_time -= 1500;
       }
@@ -266,6 +567,7 @@ void Scheduler::Aging() {
                         << iterator->Item()->priority << "}​ ] to [​ {"
                         << iterator->Item()->priority + 10 << "}​ ]");
         thread->priority += 10;
+        thread->basePriority += 10; // aging is not a donation
         thread->ready_queue_wait_time -= 1500;
       }
       iterator->Next();
@@ -282,6 +584,7 @@ void Scheduler::Aging() {
 
       if (thread->ready_queue_wait_time >= 1500) {
         thread->priority += 10;
+        thread->basePriority += 10;
         thread->ready_queue_wait_time -= 1500;
       }
       iterator->Next();
@@ -290,9 +593,9 @@ void Scheduler::Aging() {
 }
 
 //------------------------------
-// Scheduler::ReArrangeThreads
+// MultilevelClass::ReArrangeThreads
 //--------------------------------------------------------
-void Scheduler::ReArrangeThreads() {
+void MultilevelClass::ReArrangeThreads() {
   Thread *move_thread;
   ListIterator<Thread *> *iter3; // L3
   iter3 = new ListIterator<Thread *>(L3);
@@ -348,145 +651,72 @@ void Scheduler::ReArrangeThreads() {
 }
 
 //------------------------------
-// Scheduler::CheckPreempt
+// MultilevelClass::CheckPreempt
 //----------------------------------------------------------------
 
-void Scheduler::CheckPreempt(Thread *thread) {
+void MultilevelClass::CheckPreempt(Thread *thread) {
   // current thread is L3 and L1/L2 has thread added.
   if (kernel->currentThread->InWhichQueue() == 3 &&
       (thread->InWhichQueue() == 2 || thread->InWhichQueue() == 1)) {
     kernel->currentThread->T +=
         kernel->stats->totalTicks - kernel->currentThread->CPU_start_time;
-    Thread *nextThread = this->Scheduling();
-    // this->AddToQueue(kernel->currentThread, kernel->currentThread->priority);
-    this->ReadyToRun(kernel->currentThread);
-    this->Run(nextThread, FALSE);
+    Thread *nextThread = kernel->scheduler->Scheduling();
+    kernel->scheduler->ReadyToRun(kernel->currentThread);
+    kernel->scheduler->Run(nextThread, FALSE);
   } else if (kernel->currentThread->InWhichQueue() == 2 &&
              thread->InWhichQueue() == 1) {
     kernel->currentThread->T +=
         kernel->stats->totalTicks - kernel->currentThread->CPU_start_time;
-    Thread *nextThread = this->Scheduling();
-    // this->AddToQueue(kernel->currentThread, kernel->currentThread->priority);
-    this->ReadyToRun(kernel->currentThread);
-    this->Run(nextThread, FALSE);
+    Thread *nextThread = kernel->scheduler->Scheduling();
+    kernel->scheduler->ReadyToRun(kernel->currentThread);
+    kernel->scheduler->Run(nextThread, FALSE);
   } else if (kernel->currentThread->InWhichQueue() == 1 &&
              (thread->InWhichQueue() == 1 &&
               thread->ti < kernel->currentThread->ti)) {
     kernel->currentThread->T +=
         kernel->stats->totalTicks - kernel->currentThread->CPU_start_time;
-    Thread *nextThread = this->Scheduling();
-    // this->AddToQueue(kernel->currentThread, kernel->currentThread->priority);
-    this->ReadyToRun(kernel->currentThread);
-    this->Run(nextThread, FALSE);
+    Thread *nextThread = kernel->scheduler->Scheduling();
+    kernel->scheduler->ReadyToRun(kernel->currentThread);
+    kernel->scheduler->Run(nextThread, FALSE);
   }
 }
 
 //----------------------------------------------------------------------
-// Scheduler::FindNextToRun
-// 	Return the next thread to be scheduled onto the CPU.
-//	If there are no ready threads, return NULL.
-// Side effect:
-//	Thread is removed from the ready list.
+// MultilevelClass::IsEmpty
+// 	Return TRUE if all three levels are empty.
 //----------------------------------------------------------------------
 
-Thread *Scheduler::FindNextToRun() {
-  ASSERT(kernel->interrupt->getLevel() == IntOff);
+bool MultilevelClass::IsEmpty() {
+  return L1->IsEmpty() && L2->IsEmpty() && L3->IsEmpty();
+}
 
-  if (readyList->IsEmpty()) {
-    return NULL;
-  } else {
-    return readyList->RemoveFront();
-  }
+int MultilevelClass::NumReady() {
+  return L1->NumInList() + L2->NumInList() + L3->NumInList();
 }
 
 //----------------------------------------------------------------------
-// Scheduler::Run
-// 	Dispatch the CPU to nextThread.  Save the state of the old thread,
-//	and load the state of the new thread, by calling the machine
-//	dependent context switch routine, SWITCH.
-//
-//      Note: we assume the state of the previously running thread has
-//	already been changed from running to blocked or ready (depending).
-// Side effect:
-//	The global variable kernel->currentThread becomes nextThread.
-//
-//	"nextThread" is the thread to be put into the CPU.
-//	"finishing" is set if the current thread is to be deleted
-//		once we're no longer running on its stack
-//		(when the next thread starts running)
+// MultilevelClass::Tick
+// 	Age the waiting threads, and move those whose priority crossed
+//	a threshold up a level (possibly preempting the running thread).
 //----------------------------------------------------------------------
 
-void Scheduler::Run(Thread *nextThread, bool finishing) {
-  Thread *oldThread = kernel->currentThread;
-
-  ASSERT(kernel->interrupt->getLevel() == IntOff);
-
-  if (finishing) { // mark that we need to delete current thread
-    ASSERT(toBeDestroyed == NULL);
-    toBeDestroyed = oldThread;
-  }
-
-  if (oldThread->space != NULL) { // if this thread is a user program,
-    oldThread->SaveUserState();   // save the user's CPU registers
-    oldThread->space->SaveState();
-  }
-
-  oldThread->CheckOverflow(); // check if the old thread
-                              // had an undetected stack overflow
-
-  kernel->currentThread = nextThread; // switch to the next thread
-  nextThread->setStatus(RUNNING);     // nextThread is now running
-
-  DEBUG(dbgThread, "Switching from: " << oldThread->getName()
-                                      << " to: " << nextThread->getName());
-
-  // This is a machine-dependent assembly language routine defined
-  // in switch.s.  You may have to think
-  // a bit to figure out what happens after this, both from the point
-  // of view of the thread and from the perspective of the "outside world".
-
-  nextThread->ready_queue_wait_time = 0;
-
-  SWITCH(oldThread, nextThread);
-
-  // we're back, running oldThread
-
-  // interrupts are off when we return from switch!
-  ASSERT(kernel->interrupt->getLevel() == IntOff);
-
-  DEBUG(dbgThread, "Now in thread: " << oldThread->getName());
-
-  CheckToBeDestroyed(); // check if thread we were running
-                        // before this one has finished
-                        // and needs to be cleaned up
-
-  if (oldThread->space != NULL) {  // if there is an address space
-    oldThread->RestoreUserState(); // to restore, do it.
-    oldThread->space->RestoreState();
-  }
+void MultilevelClass::Tick() {
+  Aging();
+  ReArrangeThreads();
 }
 
 //----------------------------------------------------------------------
-// Scheduler::CheckToBeDestroyed
-// 	If the old thread gave up the processor because it was finishing,
-// 	we need to delete its carcass.  Note we cannot delete the thread
-// 	before now (for example, in Thread::Finish()), because up to this
-// 	point, we were still running on the old thread's stack!
+// MultilevelClass::ShouldYield
+// 	Only L3 is time sliced; L1 and L2 threads keep the CPU until
+//	they block or are preempted by CheckPreempt.
 //----------------------------------------------------------------------
 
-void Scheduler::CheckToBeDestroyed() {
-  if (toBeDestroyed != NULL) {
-    delete toBeDestroyed;
-    toBeDestroyed = NULL;
-  }
+bool MultilevelClass::ShouldYield(Thread *current) {
+  return current->InWhichQueue() == 3;
 }
 
-//----------------------------------------------------------------------
-// Scheduler::Print
-// 	Print the scheduler state -- in other words, the contents of
-//	the ready list.  For debugging.
-//----------------------------------------------------------------------
-void Scheduler::Print() {
-  cout << "Ready list contents:\n";
-  readyList->Apply(ThreadPrint);
+void MultilevelClass::Print() {
+  L1->Apply(ThreadPrint);
+  L2->Apply(ThreadPrint);
+  L3->Apply(ThreadPrint);
 }
@@ -11,46 +11,165 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "stats.h"
 #include "thread.h"
 
+// Scheduling policies that can be selected at startup (-sched).
+
+enum SchedPolicy { MultilevelPolicy, FairPolicy };
+
+// Time slices of the multilevel queue, set at startup (-quantum, -aq).
+// A level whose quantum is 0 keeps the policy's own rule: L1 and L2
+// are not time sliced, L3 yields at every timer interrupt.  Otherwise
+// a thread yields at the first timer interrupt after it has run for
+// its level's quantum.
+//
+// In adaptive mode every time-sliced thread has a quantum of its own,
+// starting from its level's (TimerTicks for L3 by default).  It
+// doubles each time the thread uses it all up, so CPU-bound threads
+// switch less, and halves each time the thread blocks having used
+// less than half of it, between MinQuantum and MaxQuantum.
+//
+// The fair policy computes its own slices, and ignores all this.
+
+const int MinQuantum = TimerTicks;
+const int MaxQuantum = 8 * TimerTicks;
+
+class Quanta {
+public:
+  Quanta(); // no quanta set, not adaptive
+
+  int level[NumSchedLevels]; // ticks, 0 for the policy's rule
+  bool adaptive;             // per-thread quanta
+};
+
+// The following class defines the interface of a scheduling class --
+// the part of the scheduler that decides the order in which ready
+// threads get the CPU.  The Scheduler does the bookkeeping common to
+// all policies (thread status, dispatch, statistics) and asks its
+// scheduling class everything else.
+//
+// All routines are called with interrupts disabled.
+
+class SchedClass {
+public:
+  virtual ~SchedClass() {}
+
+  virtual const char *getName() = 0; // policy name, for debugging
+
+  virtual void Enqueue(Thread *thread, ThreadStatus from) = 0;
+  // Put a thread on the ready queue;
+  // "from" is its status before it
+  // became ready
+  virtual Thread *PickNext() = 0; // Dequeue the thread to run next,
+                                  // NULL if none
+  virtual void Remove(Thread *thread) = 0; // Take a ready thread out
+                                           // of the queue
+  virtual Thread *Detach() { return PickNext(); }
+  // Dequeue a ready thread to move
+  // to another core's queue
+  virtual void Attach(Thread *thread) { Enqueue(thread, READY); }
+  // Queue a thread moved here from
+  // another core
+  virtual bool IsEmpty() = 0;     // Is any thread ready to run?
+  virtual int NumReady() = 0;     // How many threads are ready?
+  virtual int QueueLevel(Thread *thread) = 0;
+  // Which ready queue level (1..NumSchedLevels)
+  // the thread belongs to, for statistics
+
+  virtual void Tick() = 0; // Called on every time slice,
+                           // before ShouldYield
+  virtual void Age() {}    // Same, for the queue of a core that is
+                           // not running: just age the waiters
+  virtual bool ShouldYield(Thread *current) = 0;
+  // Should the running thread give up
+  // the CPU at this time slice?
+  virtual void Print() = 0; // Print contents of ready queue
+};
+
+// The MP3 multilevel feedback queue:
+//	L1 (priority 100..149): preemptive SJF on the approximate burst ti
+//	L2 (priority 50..99):   non-preemptive priority
+//	L3 (priority 0..49):    round robin
+// with aging of +10 priority for every 1500 ticks spent waiting.
+
+class MultilevelClass : public SchedClass {
+public:
+  MultilevelClass();
+  ~MultilevelClass();
+
+  const char *getName() { return "multilevel"; }
+  void Enqueue(Thread *thread, ThreadStatus from);
+  Thread *PickNext();
+  void Remove(Thread *thread);
+  bool IsEmpty();
+  int NumReady();
+  int QueueLevel(Thread *thread) { return thread->InWhichQueue(); }
+  void Tick();
+  void Age() { Aging(); }
+  bool ShouldYield(Thread *current);
+  void Print();
+
+private:
+  void Aging();
+  void ReArrangeThreads();
+  void CheckPreempt(Thread *thread);
+
+  SortedList<Thread *> *L1;
+  SortedList<Thread *> *L2;
+  List<Thread *> *L3;
+};
+
 // The following class defines the scheduler/dispatcher abstraction --
 // the data structures and operations needed to keep track of which
 // thread is running, and which threads are ready but not running.
 
 class Scheduler {
 public:
-  Scheduler();  // Initialize list of ready threads
-  ~Scheduler(); // De-allocate ready list
+  Scheduler(SchedPolicy policy, Quanta *quanta);
+  // Initialize list of ready threads
+  ~Scheduler();                  // De-allocate ready list
 
   void ReadyToRun(Thread *thread);
   // Thread can be dispatched.
   Thread *FindNextToRun(); // Dequeue first thread on the ready
                            // list, if any, and return thread.
+                           // On a multi-core machine, an empty
+                           // list steals from another core.
   void Run(Thread *nextThread, bool finishing);
   // Cause nextThread to start running
   void CheckToBeDestroyed(); // Check if thread that had been
                              // running needs to be deleted
+  bool IsEmpty();            // Is any thread ready to run?
+  int NumReady() { return sched->NumReady(); }
+  Thread *Detach() { return sched->Detach(); }
+  // give a ready thread to another core
   void Print();              // Print contents of ready list
 
   // add fn
-  void Aging();
-  Thread *Scheduling();
-  void AddToQueue(Thread *thread, int priority);
-  void ReArrangeThreads();
-  void CheckPreempt(Thread *thread);
+  Thread *Scheduling(); // FindNextToRun, plus the bookkeeping
+                        // for the thread about to run
+  void Tick();          // a time slice has passed
+  void Age();           // ... on another core
+  bool ShouldYield(Thread *current);
+  // should the running thread give up the CPU?
+  void SetPriority(Thread *thread, int priority);
+  // change the (effective) priority of a
+  // thread, requeueing it if it is ready
 
   // SelfTest for scheduler is implemented in class Thread
 
 private:
-  List<Thread *> *readyList; // queue of threads that are ready to run,
-                             // but not running
+  int Quantum(Thread *thread); // time slice, 0 for the policy's rule
+  void AdaptQuantum(Thread *thread, int ran, bool preempted);
+
+  SchedPolicy policy;
+  Quanta *quanta;        // time slices, shared by all cores
+  SchedClass *sched;     // policy deciding who runs next
   Thread *toBeDestroyed; // finishing thread to be destroyed
                          // by the next thread that runs
-
-  // add var
-  SortedList<Thread *> *L1;
-  SortedList<Thread *> *L2;
-  List<Thread *> *L3;
+  bool burstOpen;        // has the burst of the current thread
+                         // not been recorded yet?
 };
 
 #endif // SCHEDULER_H
@@ -16,17 +16,11 @@
 // re-set the interrupt state back to its original value (whether
 // that be disabled or enabled).
 //
-// Once we'e implemented one set of higher level atomic operations,
-// we can implement others using that implementation.  We illustrate
-// this by implementing locks and condition variables on top of 
-// semaphores, instead of directly enabling and disabling interrupts.
-//
-// Locks are implemented using a semaphore to keep track of
-// whether the lock is held or not -- a semaphore value of 0 means
-// the lock is busy; a semaphore value of 1 means the lock is free.
-//
-// The implementation of condition variables using semaphores is
-// a bit trickier, as explained below under Condition::Wait.
+// Locks and condition variables keep their own queues of waiting
+// threads, sorted by priority, rather than being built on (FIFO)
+// semaphores: the highest priority waiter is woken first, and a lock
+// needs to know who is waiting for it to lend its holder their
+// priority (see synch.h).
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -149,49 +143,88 @@ Semaphore::SelfTest()
     delete ping;
 }
 
+//----------------------------------------------------------------------
+// PriorityCompare
+// 	Order waiting threads highest priority first.  SortedList::Insert
+//	puts an item after those equal to it, so equal priorities are
+//	served FIFO.
+//----------------------------------------------------------------------
+
+static int
+PriorityCompare(Thread *x, Thread *y)
+{
+    if (x->priority > y->priority)
+	return -1;
+    if (x->priority < y->priority)
+	return 1;
+    return 0;
+}
+
 //----------------------------------------------------------------------
 // Lock::Lock
 // 	Initialize a lock, so that it can be used for synchronization.
 //	Initially, unlocked.
 //
 //	"debugName" is an arbitrary name, useful for debugging.
+//	"ceilingPriority" is the priority its holder runs at, or
+//		NoCeiling to use priority inheritance instead.
 //----------------------------------------------------------------------
 
-Lock::Lock(char* debugName)
+Lock::Lock(char* debugName, int ceilingPriority)
 {
     name = debugName;
-    semaphore = new Semaphore("lock", 1);  // initially, unlocked
-    lockHolder = NULL;
+    lockHolder = NULL;		// initially, unlocked
+    waiters = new SortedList<Thread *>(PriorityCompare);
+    ceiling = ceilingPriority;
+    nextHeld = NULL;
 }
 
 //----------------------------------------------------------------------
 // Lock::~Lock
-// 	Deallocate a lock
+// 	Deallocate a lock.  Assume no one is still waiting on it!
 //----------------------------------------------------------------------
 Lock::~Lock()
 {
-    delete semaphore;
+    delete waiters;
 }
 
 //----------------------------------------------------------------------
 // Lock::Acquire
 //	Atomically wait until the lock is free, then set it to busy.
-//	Equivalent to Semaphore::P(), with the semaphore value of 0
-//	equal to busy, and semaphore value of 1 equal to free.
+//
+//	While waiting, lend our priority to the holder (unless this is
+//	a priority ceiling lock).  Once we have the lock, our own
+//	priority may go up: to the ceiling, or to that of a thread
+//	still waiting.
 //----------------------------------------------------------------------
 
 void Lock::Acquire()
 {
-    semaphore->P();
-    lockHolder = kernel->currentThread;
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(!IsHeldByCurrentThread());
+    while (lockHolder != NULL) {		// lock busy
+	waiters->Insert(currentThread);		// so go to sleep
+	currentThread->waitingFor = this;
+	if (ceiling == NoCeiling)
+	    Donate(currentThread->priority);
+	currentThread->Sleep(FALSE);
+    }
+    lockHolder = currentThread;
+    nextHeld = currentThread->locksHeld;
+    currentThread->locksHeld = this;
+    UpdatePriority(currentThread);
+
+    (void) interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
 // Lock::Release
-//	Atomically set lock to be free, waking up a thread waiting
-//	for the lock, if any.
-//	Equivalent to Semaphore::V(), with the semaphore value of 0
-//	equal to busy, and semaphore value of 1 equal to free.
+//	Atomically set lock to be free, waking up the highest priority
+//	thread waiting for the lock, if any.  Give back whatever
+//	priority we had because of this lock.
 //
 //	By convention, only the thread that acquired the lock
 // 	may release it.
@@ -199,9 +232,84 @@ void Lock::Acquire()
 
 void Lock::Release()
 {
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Lock **prev;
+
     ASSERT(IsHeldByCurrentThread());
+    for (prev = &currentThread->locksHeld; *prev != this;
+	 prev = &(*prev)->nextHeld)
+	ASSERT(*prev != NULL);
+    *prev = nextHeld;
+    nextHeld = NULL;
     lockHolder = NULL;
-    semaphore->V();
+    UpdatePriority(currentThread);
+
+    if (!waiters->IsEmpty()) {		// make thread ready
+	Thread *thread = waiters->RemoveFront();
+	thread->waitingFor = NULL;
+	kernel->scheduler->ReadyToRun(thread);
+    }
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Lock::Donate
+//	Raise the holder of this lock to at least "priority".  If the
+//	holder is itself waiting for a lock, move it up in that lock's
+//	queue and raise that lock's holder too, and so on down the
+//	chain.  Stops at a thread already that important (which also
+//	ends a deadlock cycle), or at a priority ceiling lock.
+//
+//	Interrupts must be disabled.
+//----------------------------------------------------------------------
+
+void
+Lock::Donate(int priority)
+{
+    Lock *lock = this;
+    Thread *holder;
+
+    while ((holder = lock->lockHolder) != NULL && holder->priority < priority) {
+	DEBUG(dbgThread, "Lock " << lock->name << ": raising "
+		<< holder->getName() << " to priority " << priority);
+	kernel->scheduler->SetPriority(holder, priority);
+	lock = holder->waitingFor;
+	if (lock == NULL)
+	    break;
+	lock->waiters->Remove(holder);	// keep its place in line right
+	lock->waiters->Insert(holder);
+	if (lock->ceiling != NoCeiling)
+	    break;
+    }
+}
+
+//----------------------------------------------------------------------
+// Lock::UpdatePriority
+//	Recompute the effective priority of "thread" from its base
+//	priority and the locks it still holds: the ceiling of each
+//	ceiling lock, and the highest waiter of each other lock.
+//
+//	Interrupts must be disabled.
+//----------------------------------------------------------------------
+
+void
+Lock::UpdatePriority(Thread *thread)
+{
+    int priority = thread->basePriority;
+
+    for (Lock *lock = thread->locksHeld; lock != NULL; lock = lock->nextHeld) {
+	if (lock->ceiling != NoCeiling) {
+	    if (lock->ceiling > priority)
+		priority = lock->ceiling;
+	} else if (!lock->waiters->IsEmpty() &&
+		   lock->waiters->Front()->priority > priority) {
+	    priority = lock->waiters->Front()->priority;
+	}
+    }
+    kernel->scheduler->SetPriority(thread, priority);
 }
 
 //----------------------------------------------------------------------
@@ -215,7 +323,7 @@ void Lock::Release()
 Condition::Condition(char* debugName)
 {
     name = debugName;
-    waitQueue = new List<Semaphore *>;
+    waitQueue = new SortedList<Thread *>(PriorityCompare);
 }
 
 //----------------------------------------------------------------------
@@ -231,11 +339,9 @@ Condition::~Condition()
 //----------------------------------------------------------------------
 // Condition::Wait
 // 	Atomically release monitor lock and go to sleep.
-//	Our implementation uses semaphores to implement this, by
-//	allocating a semaphore for each waiting thread.  The signaller
-//	will V() this semaphore, so there is no chance the waiter
-//	will miss the signal, even though the lock is released before
-//	calling P().
+//	Interrupts stay disabled from queueing ourselves until we are
+//	asleep, so there is no chance to miss the signal, even though
+//	the lock is released before sleeping.
 //
 //	Note: we assume Mesa-style semantics, which means that the
 //	waiter must re-acquire the monitor lock when waking up.
@@ -245,43 +351,48 @@ Condition::~Condition()
 
 void Condition::Wait(Lock* conditionLock) 
 {
-     Semaphore *waiter;
-    
-     ASSERT(conditionLock->IsHeldByCurrentThread());
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
+    IntStatus oldLevel;
 
-     waiter = new Semaphore("condition", 0);
-     waitQueue->Append(waiter);
-     conditionLock->Release();
-     waiter->P();
-     conditionLock->Acquire();
-     delete waiter;
+    ASSERT(conditionLock->IsHeldByCurrentThread());
+
+    oldLevel = interrupt->SetLevel(IntOff);
+    waitQueue->Insert(currentThread);
+    conditionLock->Release();
+    currentThread->Sleep(FALSE);
+    (void) interrupt->SetLevel(oldLevel);
+
+    conditionLock->Acquire();
 }
 
 //----------------------------------------------------------------------
 // Condition::Signal
-// 	Wake up a thread waiting on this condition, if any.
+// 	Wake up the highest priority thread waiting on this condition,
+//	if any.
 //
 //	Note: we assume Mesa-style semantics, which means that the
 //	signaller doesn't give up control immediately to the thread
 //	being woken up (unlike Hoare-style).
 //
 //	Also note: we assume the caller holds the monitor lock
-//	(unlike what is described in Birrell's paper).  This allows
-//	us to access waitQueue without disabling interrupts.
+//	(unlike what is described in Birrell's paper).  Interrupts
+//	are disabled only because ReadyToRun requires it.
 //
 //	"conditionLock" -- lock protecting the use of this condition
 //----------------------------------------------------------------------
 
 void Condition::Signal(Lock* conditionLock)
 {
-    Semaphore *waiter;
-    
+    IntStatus oldLevel;
+
     ASSERT(conditionLock->IsHeldByCurrentThread());
-    
+
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
     if (!waitQueue->IsEmpty()) {
-        waiter = waitQueue->RemoveFront();
-	waiter->V();
+	kernel->scheduler->ReadyToRun(waitQueue->RemoveFront());
     }
+    (void) kernel->interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
@@ -297,3 +408,303 @@ void Condition::Broadcast(Lock* conditionLock)
         Signal(conditionLock);
     }
 }
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader-writer lock.  Initially, no one holds it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char* debugName)
+{
+    name = debugName;
+    lock = new Lock(debugName);
+    readersOk = new Condition(debugName);
+    writersOk = new Condition(debugName);
+    readers = waitingWriters = 0;
+    writer = NULL;
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+// 	Deallocate a reader-writer lock.  Assume no one holds it!
+//----------------------------------------------------------------------
+
+RWLock::~RWLock()
+{
+    ASSERT(readers == 0 && writer == NULL);
+    delete writersOk;
+    delete readersOk;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireRead
+// 	Wait until there is no writer, holding or waiting for the lock,
+//	then join the readers.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireRead()
+{
+    lock->Acquire();
+    while (writer != NULL || waitingWriters > 0)
+	readersOk->Wait(lock);
+    readers++;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseRead
+// 	Leave the readers; the last one out lets a waiting writer in.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseRead()
+{
+    lock->Acquire();
+    ASSERT(readers > 0);
+    readers--;
+    if (readers == 0 && waitingWriters > 0)
+	writersOk->Signal(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireWrite
+// 	Wait until no one holds the lock, then take it alone.  Being
+//	counted in "waitingWriters" keeps new readers out meanwhile.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireWrite()
+{
+    lock->Acquire();
+    ASSERT(writer != kernel->currentThread);
+    waitingWriters++;
+    while (writer != NULL || readers > 0)
+	writersOk->Wait(lock);
+    waitingWriters--;
+    writer = kernel->currentThread;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseWrite
+// 	Give up the lock: to the next writer if one is waiting (writer
+//	preference), otherwise to all waiting readers.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseWrite()
+{
+    lock->Acquire();
+    ASSERT(IsWriteHeldByCurrentThread());
+    writer = NULL;
+    if (waitingWriters > 0)
+	writersOk->Signal(lock);
+    else
+	readersOk->Broadcast(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::SelfTest, RWLockReader, RWLockWriter
+// 	Test the reader-writer lock, by running several readers and
+//	writers over a shared counter, yielding while they hold the
+//	lock.  Readers check that the counter does not change under
+//	them; writers check that they are alone.
+//----------------------------------------------------------------------
+
+static RWLock *rwLock;
+static Semaphore *rwDone;
+static int rwValue, rwReaders;
+static bool rwWriting;
+
+static void
+RWLockReader(int rounds)
+{
+    for (int i = 0; i < rounds; i++) {
+	rwLock->AcquireRead();
+	int value = rwValue;
+	ASSERT(!rwWriting);
+	rwReaders++;
+	kernel->currentThread->Yield();
+	ASSERT(rwValue == value);
+	rwReaders--;
+	rwLock->ReleaseRead();
+	kernel->currentThread->Yield();
+    }
+    rwDone->V();
+}
+
+static void
+RWLockWriter(int rounds)
+{
+    for (int i = 0; i < rounds; i++) {
+	rwLock->AcquireWrite();
+	ASSERT(!rwWriting && rwReaders == 0);
+	rwWriting = TRUE;
+	kernel->currentThread->Yield();
+	rwValue++;
+	rwWriting = FALSE;
+	rwLock->ReleaseWrite();
+	kernel->currentThread->Yield();
+    }
+    rwDone->V();
+}
+
+void
+RWLock::SelfTest()
+{
+    const int rounds = 5;
+
+    rwLock = this;
+    rwDone = new Semaphore("rwDone", 0);
+    rwValue = rwReaders = 0;
+    rwWriting = FALSE;
+    for (int i = 0; i < 3; i++)
+	(new Thread("reader", 1))->Fork((VoidFunctionPtr) RWLockReader,
+					(void *) rounds);
+    for (int i = 0; i < 2; i++)
+	(new Thread("writer", 1))->Fork((VoidFunctionPtr) RWLockWriter,
+					(void *) rounds);
+    for (int i = 0; i < 5; i++)
+	rwDone->P();
+    ASSERT(rwValue == 2 * rounds);
+    delete rwDone;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::SeqLock
+// 	Initialize a sequence lock.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+SeqLock::SeqLock(char* debugName)
+{
+    name = debugName;
+    writeLock = new Lock(debugName);
+    sequence = 0;
+}
+
+SeqLock::~SeqLock()
+{
+    delete writeLock;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::ReadBegin
+// 	Return an even sequence number to check the read against.  If
+//	a write is in progress, wait for it by taking the writers' lock
+//	(which also lends the writer our priority) rather than spinning.
+//----------------------------------------------------------------------
+
+unsigned int
+SeqLock::ReadBegin()
+{
+    unsigned int seq;
+
+    while ((seq = sequence) & 1) {
+	writeLock->Acquire();
+	writeLock->Release();
+    }
+    return seq;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::ReadRetry
+// 	Return TRUE if the data read since ReadBegin returned "seq" may
+//	be inconsistent, because a write started since then.
+//----------------------------------------------------------------------
+
+bool
+SeqLock::ReadRetry(unsigned int seq)
+{
+    return sequence != seq;
+}
+
+//----------------------------------------------------------------------
+// SeqLock::WriteBegin, SeqLock::WriteEnd
+// 	Bracket an update.  The sequence number is odd in between.
+//----------------------------------------------------------------------
+
+void
+SeqLock::WriteBegin()
+{
+    writeLock->Acquire();
+    sequence++;
+    ASSERT(sequence & 1);
+}
+
+void
+SeqLock::WriteEnd()
+{
+    ASSERT(writeLock->IsHeldByCurrentThread());
+    sequence++;
+    writeLock->Release();
+}
+
+//----------------------------------------------------------------------
+// SeqLock::SelfTest, SeqLockWriter, SeqLockReader
+// 	Test the sequence lock: a writer keeps setting a pair of values
+//	to the same number, yielding half way through each update, while
+//	a reader, also yielding half way, checks that it never accepts a
+//	mixed pair.
+//----------------------------------------------------------------------
+
+static SeqLock *seqLock;
+static Semaphore *seqDone;
+static int seqFirst, seqSecond;
+
+static void
+SeqLockWriter(int rounds)
+{
+    for (int i = 1; i <= rounds; i++) {
+	seqLock->WriteBegin();
+	seqFirst = i;
+	kernel->currentThread->Yield();
+	seqSecond = i;
+	seqLock->WriteEnd();
+	kernel->currentThread->Yield();
+    }
+    seqDone->V();
+}
+
+static void
+SeqLockReader(int rounds)
+{
+    int first, second;
+    unsigned int seq;
+
+    for (int i = 0; i < rounds; i++) {
+	do {
+	    seq = seqLock->ReadBegin();
+	    first = seqFirst;
+	    kernel->currentThread->Yield();
+	    second = seqSecond;
+	} while (seqLock->ReadRetry(seq));
+	ASSERT(first == second);
+    }
+    seqDone->V();
+}
+
+void
+SeqLock::SelfTest()
+{
+    const int rounds = 10;
+
+    seqLock = this;
+    seqDone = new Semaphore("seqDone", 0);
+    seqFirst = seqSecond = 0;
+    (new Thread("seqwriter", 1))->Fork((VoidFunctionPtr) SeqLockWriter,
+				       (void *) rounds);
+    (new Thread("seqreader", 1))->Fork((VoidFunctionPtr) SeqLockReader,
+				       (void *) (2 * rounds));
+    seqDone->P();
+    seqDone->P();
+    ASSERT(seqFirst == rounds && seqSecond == rounds);
+    delete seqDone;
+}
@@ -1,11 +1,9 @@
 // synch.h 
 //	Data structures for synchronizing threads.
 //
-//	Three kinds of synchronization are defined here: semaphores,
-//	locks, and condition variables.  The implementation for
-//	semaphores is given; for the latter two, only the procedure
-//	interface is given -- they are to be implemented as part of 
-//	the first assignment.
+//	Five kinds of synchronization are defined here: semaphores,
+//	locks, condition variables, and, for data that is read far more
+//	often than it is written, reader-writer locks and sequence locks.
 //
 //	Note that all the synchronization objects take a "name" as
 //	part of the initialization.  This is solely for debugging purposes.
@@ -65,10 +63,26 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// To bound priority inversion, waiters are woken highest priority
+// first, and the holder runs at a raised (effective) priority:
+//
+//	by default, priority inheritance -- the holder runs at the
+//	priority of its highest waiter, transitively through chains
+//	of locks;
+//
+//	with a "ceiling", priority ceiling -- the holder runs at the
+//	ceiling priority as long as it holds the lock.
+//
+// With nested locks, the holder's priority is recomputed from the
+// locks it still holds on each Release.
+
+const int NoCeiling = -1;
 
 class Lock {
   public:
-    Lock(char* debugName);  	// initialize lock to be FREE
+    Lock(char* debugName, int ceilingPriority = NoCeiling);
+				// initialize lock to be FREE
     ~Lock();			// deallocate lock
     char* getName() { return name; }	// debugging assist
 
@@ -85,7 +99,15 @@ class Lock {
   private:
     char *name;			// debugging assist
     Thread *lockHolder;		// thread currently holding lock
-    Semaphore *semaphore;	// we use a semaphore to implement lock
+    SortedList<Thread *> *waiters;	// threads waiting in Acquire,
+				// highest priority first
+    int ceiling;		// NoCeiling for priority inheritance
+    Lock *nextHeld;		// next lock held by lockHolder
+
+    void Donate(int priority);	// raise the holder (and whoever it
+				// waits for) to at least "priority"
+    static void UpdatePriority(Thread *thread);
+				// recompute thread's effective priority
 };
 
 // The following class defines a "condition variable".  A condition
@@ -139,6 +161,82 @@ class Condition {
 
   private:
     char* name;
-    List<Semaphore *> *waitQueue;	// list of waiting threads
+    SortedList<Thread *> *waitQueue;	// waiting threads, highest
+					// priority first
+};
+
+// The following class defines a "reader-writer lock".  Any number of
+// readers may hold it at once, or a single writer.
+//
+// Writers have preference: once a writer is waiting, new readers wait
+// behind it, so a steady stream of readers cannot starve writers.  The
+// flip side is that a thread must not take the read lock twice -- if a
+// writer arrives in between, the second AcquireRead waits for the
+// writer, which waits for the first read to be released.
+//
+// It is built from a Lock and two Conditions, so waiters are woken in
+// priority order, and a waiting writer lends its priority to the
+// readers or writer in its way only while they hold the inner lock.
+
+class RWLock {
+  public:
+    RWLock(char* debugName);		// initialize lock to be FREE
+    ~RWLock();				// deallocate lock
+    char* getName() { return name; }
+
+    void AcquireRead();			// share the lock with other readers
+    void ReleaseRead();
+    void AcquireWrite();		// hold the lock alone
+    void ReleaseWrite();
+
+    bool IsWriteHeldByCurrentThread() {
+		return writer == kernel->currentThread; }
+
+    void SelfTest();			// test routine for RWLock
+
+  private:
+    char* name;				// for debugging
+    Lock *lock;				// protects the fields below
+    Condition *readersOk;		// signalled when readers may enter
+    Condition *writersOk;		// signalled when a writer may enter
+    int readers;			// threads holding the read lock
+    int waitingWriters;			// threads waiting in AcquireWrite
+    Thread *writer;			// thread holding the write lock, or NULL
+};
+
+// The following class defines a "sequence lock".  Writers exclude each
+// other and bump a sequence number before and after each update;
+// readers never block writers, they just read optimistically and retry
+// if a write overlapped:
+//
+//	do {
+//	    seq = seqLock->ReadBegin();
+//	    ... copy the protected data ...
+//	} while (seqLock->ReadRetry(seq));
+//
+// This suits small data that is read very often and written rarely.
+// The read side must only copy -- it may see a half-written update,
+// which it discards when ReadRetry says so.
+
+class SeqLock {
+  public:
+    SeqLock(char* debugName);		// initialize, no write in progress
+    ~SeqLock();
+    char* getName() { return name; }
+
+    unsigned int ReadBegin();		// wait out any write in progress,
+					// return the sequence number
+    bool ReadRetry(unsigned int seq);	// TRUE if a write happened since
+					// ReadBegin returned "seq"
+    void WriteBegin();
+    void WriteEnd();
+
+    void SelfTest();			// test routine for SeqLock
+
+  private:
+    char* name;				// for debugging
+    Lock *writeLock;			// writers exclude each other
+    unsigned int sequence;		// odd while a write is in progress
 };
+
 #endif // SYNCH_H
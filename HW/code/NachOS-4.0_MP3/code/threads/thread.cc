@@ -25,6 +25,43 @@
 // this is put at the top of the execution stack, for detecting stack overflows
 const int STACK_FENCEPOST = 0xdedbeef;
 
+// Finished threads hand their execution stacks (guard pages and all)
+// and their control blocks back to these pools, so that the next Fork
+// can reuse them instead of going back to the host allocator.
+const int MaxPooledStacks = 64;
+const int MaxPooledThreads = 64;
+
+static int *stackPool[MaxPooledStacks];
+static int numPooledStacks = 0;
+static void *threadPool[MaxPooledThreads];
+static int numPooledThreads = 0;
+
+//----------------------------------------------------------------------
+// Thread::operator new, Thread::operator delete
+// 	Recycle thread control blocks.  Threads are deleted by
+//	Scheduler::CheckToBeDestroyed once they finish; keep the memory
+//	around for the next "new Thread".
+//----------------------------------------------------------------------
+
+void *Thread::operator new(size_t size) {
+  ASSERT(size == sizeof(Thread));
+  if (numPooledThreads > 0) {
+    return threadPool[--numPooledThreads];
+  }
+  return ::operator new(size);
+}
+
+void Thread::operator delete(void *p) {
+  if (p == NULL) {
+    return;
+  }
+  if (numPooledThreads < MaxPooledThreads) {
+    threadPool[numPooledThreads++] = p;
+  } else {
+    ::operator delete(p);
+  }
+}
+
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
@@ -45,11 +82,18 @@ Thread::Thread(char *threadName, int threadID) {
                             // of machine registers
   }
   space = NULL;
-  priority = 0;
-  ti = 0; // t0 = 0.
+  priority = basePriority = 0;
+  locksHeld = waitingFor = NULL;
+  readyOn = NULL;
+  ti = last_ti = 0; // t0 = 0.
+  T = 0;
   CPU_start_time = CPU_end_time = 0;
   ready_queue_wait_time = 0; // t0 = 0.
   enter_ready_time = 0;
+  vruntime = 0;
+  enqueue_time = fork_time = 0;
+  numBursts = 0;
+  quantum = 0;
 }
 
 Thread::Thread(char *threadName, int threadID, int _priority) {
@@ -64,11 +108,18 @@ Thread::Thread(char *threadName, int threadID, int _priority) {
                             // of machine registers
   }
   space = NULL; // user space. NOT kernel space
-  priority = _priority;
-  ti = 0; // t0 = 0.
+  priority = basePriority = _priority;
+  locksHeld = waitingFor = NULL;
+  readyOn = NULL;
+  ti = last_ti = 0; // t0 = 0.
+  T = 0;
   CPU_start_time = CPU_end_time = 0;
   ready_queue_wait_time = 0; // t0 = 0.
   enter_ready_time = 0;
+  vruntime = 0;
+  enqueue_time = fork_time = 0;
+  numBursts = 0;
+  quantum = 0;
 }
 
 //----------------------------------------------------------------------
@@ -86,8 +137,16 @@ Thread::Thread(char *threadName, int threadID, int _priority) {
 Thread::~Thread() {
   DEBUG(dbgThread, "Deleting thread: " << name);
   ASSERT(this != kernel->currentThread);
-  if (stack != NULL)
-    DeallocBoundedArray((char *)stack, StackSize * sizeof(int));
+  if (space != NULL && --space->numThreads == 0) {
+    delete space; // we were the last thread of the program
+  }
+  if (stack != NULL) {
+    if (numPooledStacks < MaxPooledStacks) {
+      stackPool[numPooledStacks++] = stack; // keep it for the next Fork
+    } else {
+      DeallocBoundedArray((char *)stack, StackSize * sizeof(int));
+    }
+  }
 }
 
 // add fn (MP3)
@@ -105,11 +164,14 @@ int Thread::InWhichQueue() {
 
 //----------------------------------------------------------------------
 // Thread::update_ti
+//	A CPU burst ended: score the old prediction, and ask the burst
+//	predictor (see predictor.h) for the next one.
 //----------------------------------------------------------------------
 void Thread::update_ti(int cpu_end_time) {
   this->CPU_end_time = cpu_end_time;
   this->T += this->CPU_end_time - this->CPU_start_time;
-  this->ti = 0.5 * (this->T) + 0.5 * (this->last_ti);
+  kernel->stats->RecordPrediction(this->ti, this->T);
+  this->ti = kernel->predictor->Update(this, this->T);
 
   DEBUG(dbgZ, "[D]  Tick [​ {"
                   << kernel->stats->totalTicks << "}​ ]: Thread [​ {"
@@ -150,6 +212,7 @@ void Thread::Fork(VoidFunctionPtr func, void *arg) {
   DEBUG(dbgThread,
         "Forking thread: " << name << " f(a): " << (int)func << " " << arg);
   StackAllocate(func, arg);
+  fork_time = kernel->stats->totalTicks;
 
   oldLevel = interrupt->SetLevel(IntOff);
   scheduler->ReadyToRun(this); // ReadyToRun assumes that interrupts
@@ -159,6 +222,19 @@ void Thread::Fork(VoidFunctionPtr func, void *arg) {
   (void)interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Thread::Prepare
+// 	Like Fork, but don't put the thread on the ready queue; it
+//	starts running (*func)(arg) the first time something switches
+//	to it directly.  Used for the idle threads of the simulated
+//	cores (see cpu.cc).
+//----------------------------------------------------------------------
+
+void Thread::Prepare(VoidFunctionPtr func, void *arg) {
+  DEBUG(dbgThread, "Preparing thread: " << name);
+  StackAllocate(func, arg);
+}
+
 //----------------------------------------------------------------------
 // Thread::CheckOverflow
 // 	Check a thread's stack to see if it has overrun the space
@@ -224,6 +300,10 @@ void Thread::Finish() {
   ASSERT(this == kernel->currentThread);
 
   DEBUG(dbgThread, "Finishing thread: " << name);
+  if (space != NULL) { // a user program is done
+    kernel->stats->turnaround.Record(kernel->stats->totalTicks - fork_time);
+  }
+  kernel->stats->numThreadsFinished++;
   Sleep(TRUE); // invokes SWITCH
                // not reached
 }
@@ -254,13 +334,11 @@ void Thread::Yield() {
 
   DEBUG(dbgThread, "Yielding thread: " << name);
 
-  kernel->scheduler->Aging();
-  kernel->scheduler->ReArrangeThreads();
+  kernel->scheduler->Tick();
 
-  if (kernel->currentThread->InWhichQueue() == 3) {
+  if (kernel->scheduler->ShouldYield(this)) {
     nextThread = kernel->scheduler->Scheduling();
     if (nextThread != NULL) {
-      //   kernel->scheduler->AddToQueue(this, this->priority);
       kernel->scheduler->ReadyToRun(this);
       kernel->scheduler->Run(nextThread, FALSE);
     }
@@ -312,6 +390,10 @@ void Thread::Sleep(bool finishing) {
   }
 
   while ((nextThread = kernel->scheduler->Scheduling()) == NULL) {
+    if (kernel->cpus != NULL) { // the core's idle thread waits
+      nextThread = kernel->cpus->IdleThread();
+      break;
+    }
     kernel->interrupt->Idle(); // no one to run, wait for an interrupt
   }
 
@@ -364,12 +446,19 @@ static void *PLabelToAddr(void *plabel) {
 //		calls (*func)(arg)
 //		calls Thread::Finish
 //
+//	Stacks of finished threads are reused when available; they keep
+//	the guard pages AllocBoundedArray put around them.
+//
 //	"func" is the procedure to be forked
 //	"arg" is the parameter to be passed to the procedure
 //----------------------------------------------------------------------
 
 void Thread::StackAllocate(VoidFunctionPtr func, void *arg) {
-  stack = (int *)AllocBoundedArray(StackSize * sizeof(int));
+  if (numPooledStacks > 0) {
+    stack = stackPool[--numPooledStacks]; // recycled from a finished thread
+  } else {
+    stack = (int *)AllocBoundedArray(StackSize * sizeof(int));
+  }
 
 #ifdef PARISC
   // HP stack works from low addresses to high addresses
@@ -56,6 +56,13 @@
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 const int StackSize = (8 * 1024); // in words
 
+class Lock;
+class Scheduler;
+
+// Number of recent CPU bursts a thread remembers, for burst predictors
+// that look further back than the last prediction.
+const int MaxBurstWindow = 8;
+
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED, ZOMBIE };
 
@@ -85,10 +92,16 @@ public:
              // must not be running when delete
              // is called
 
+  void *operator new(size_t size); // thread control blocks
+  void operator delete(void *p);   // are recycled, see thread.cc
+
   // basic thread operations
 
   void Fork(VoidFunctionPtr func, void *arg);
   // Make thread run (*func)(arg)
+  void Prepare(VoidFunctionPtr func, void *arg);
+  // Same, but the thread is started by
+  // switching to it, not made ready
   void Yield();               // Relinquish the CPU if any
                               // other thread is runnable
   void Sleep(bool finishing); // Put the thread to sleep and
@@ -109,11 +122,24 @@ public:
   double ti;
   double last_ti; // t_i-1
   int T;          // True ticks
-  int priority;
+  int priority;     // effective priority, what the scheduler uses
+  int basePriority; // priority before any boost from the locks held
+  Lock *locksHeld;  // locks held, linked through Lock::nextHeld
+  Lock *waitingFor; // lock being waited for in Acquire, if any
+  Scheduler *readyOn; // whose ready queue it was put on last; with
+                      // several cores, not always kernel->scheduler
   int CPU_start_time;
   int CPU_end_time;
   int ready_queue_wait_time; // total time in ready queue
   int enter_ready_time;
+  double vruntime; // weighted CPU time, for FairClass
+  int enqueue_time; // when it last became ready; unlike
+                    // enter_ready_time, not reset by aging
+  int fork_time;    // when it was forked, for turnaround time
+  int recentBursts[MaxBurstWindow]; // ring of the last bursts
+  int numBursts;                    // bursts so far
+  int quantum;                      // adaptive time slice, in ticks;
+                                    // 0 until it is first needed
   // add fn
   int InWhichQueue(); // return this thread in which level of ready queue
   void set_start_wait_time(int time) { this->enter_ready_time = time; }
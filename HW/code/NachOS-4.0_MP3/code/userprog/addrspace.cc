@@ -20,9 +20,24 @@
 #include "addrspace.h"
 #include "machine.h"
 #include "noff.h"
+#include "pagecache.h"
+#include "pageprofile.h"
+#include "proctable.h"
+#include "synch.h"
 
-int AddrSpace::NumFreePage = NumPhysPages;
-bool AddrSpace::usedPhysicalPage[NumPhysPages] = {false};
+int AddrSpace::NumFreePage = 0;
+bool *AddrSpace::usedPhysicalPage = NULL;	// see InitFrames
+int *AddrSpace::frameRefs = NULL;
+int AddrSpace::generation = 1;
+int AddrSpace::nextASID = 0;
+AddrSpace *AddrSpace::asidOwner[MaxASIDs];
+
+// pages of each extra thread's stack
+#define StackPages divRoundUp(UserStackSize, PageSize)
+
+// program pages read per fault, at first and at most (see ClusterSize)
+static const int InitialCluster = 4;
+static const int MaxCluster = 16;
 
 //----------------------------------------------------------------------
 // SwapHeader
@@ -82,6 +97,21 @@ AddrSpace::AddrSpace()
     
     // // zero out the entire address space
     // bzero(kernel->machine->mainMemory, MemorySize);
+    pageTable = NULL;
+    copyOnWrite = NULL;
+    profile = NULL;
+    executable = NULL;
+    noffH = NULL;
+    filePages = 0;
+    asid = asidGeneration = 0;		// none yet
+    numPages = basePages = 0;
+    pid = numThreads = 0;
+    argc = 0;
+    argv = NULL;
+    for (int i = 0; i < MaxUserThreads; i++) {
+	slots[i].thread = NULL;
+	slots[i].done = NULL;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -91,13 +121,342 @@ AddrSpace::AddrSpace()
 
 AddrSpace::~AddrSpace()
 {
+    if (profile != NULL) {
+	SampleWorkingSet();		// the last interval
+	profile->Print(pid);
+	delete profile;
+    }
     for(int i = 0; i < numPages; i++){
-        AddrSpace::usedPhysicalPage[pageTable[i].physicalPage] = false;
-        AddrSpace::NumFreePage++;
+	if (!pageTable[i].valid)
+	    continue;			// a stack nobody uses
+	FreeFrame(pageTable[i].physicalPage);
+    }
+   delete [] pageTable;
+    delete [] copyOnWrite;
+    for (int i = 0; i < MaxUserThreads; i++)
+	delete slots[i].done;
+    for (int i = 0; i < argc; i++)
+	delete [] argv[i];
+    delete [] argv;
+    delete executable;			// close file
+    delete noffH;
+    if (asidGeneration == generation)
+	asidOwner[asid] = NULL;		// its TLB entries are stale
+    if (pid > 0)
+	kernel->processes->Release(pid);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::InitFrames, AddrSpace::DeleteFrames
+// 	Set up the frame tables, all frames free, once the size of
+//	physical memory is known; and free them at the end.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::InitFrames()
+{
+    usedPhysicalPage = new bool[NumPhysPages];
+    frameRefs = new int[NumPhysPages];
+    for (int i = 0; i < NumPhysPages; i++) {
+	usedPhysicalPage[i] = false;
+	frameRefs[i] = 0;
     }
-   delete pageTable;
+    NumFreePage = NumPhysPages;
+}
+
+void
+AddrSpace::DeleteFrames()
+{
+    delete [] usedPhysicalPage;
+    delete [] frameRefs;
+    usedPhysicalPage = NULL;
+    frameRefs = NULL;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::AllocFrame, AddrSpace::RefFrame, AddrSpace::FreeFrame
+// 	Manage physical page frames.  A frame is free until it is
+//	allocated; then it stays in use until every page table entry
+//	(or the page cache) that maps it has let go of it.
+//
+//	When no frame is free, AllocFrame makes room by dropping program
+//	pages that only the page cache still holds.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::AllocFrame()
+{
+    int frame = 0;
+
+    if (NumFreePage == 0 && !kernel->pageCache->Evict())
+	return -1;
+    while (usedPhysicalPage[frame])
+	frame++;
+    usedPhysicalPage[frame] = true;
+    frameRefs[frame] = 1;
+    NumFreePage--;
+    bzero(&kernel->machine->mainMemory[frame * PageSize], PageSize);
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AllocFrames
+// 	Take "n" contiguous zeroed free frames, the first a multiple of
+//	"n" (a power of two), for a superpage.  Return the first, or -1
+//	if there is no such run; no cached pages are evicted to make one.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::AllocFrames(int n)
+{
+    for (int first = 0; first + n <= NumPhysPages; first += n) {
+	int i = first;
+
+	while (i < first + n && !usedPhysicalPage[i])
+	    i++;
+	if (i < first + n)
+	    continue;
+	for (i = first; i < first + n; i++) {
+	    usedPhysicalPage[i] = true;
+	    frameRefs[i] = 1;
+	}
+	NumFreePage -= n;
+	bzero(&kernel->machine->mainMemory[first * PageSize], n * PageSize);
+	return first;
+    }
+    return -1;
+}
+
+void
+AddrSpace::RefFrame(int frame)
+{
+    ASSERT(usedPhysicalPage[frame] && frameRefs[frame] > 0);
+    frameRefs[frame]++;
+}
+
+void
+AddrSpace::FreeFrame(int frame)
+{
+    ASSERT(usedPhysicalPage[frame] && frameRefs[frame] > 0);
+    if (--frameRefs[frame] == 0) {
+	usedPhysicalPage[frame] = false;
+	NumFreePage++;
+    }
+}
+
+//----------------------------------------------------------------------
+// ReadOverlap
+// 	Read the part of segment "seg" of "executable" that falls in
+//	virtual pages "first" to "first" + "count" - 1 into "buf", which
+//	holds those pages: one read, however many pages it spans.
+//----------------------------------------------------------------------
+
+static void
+ReadOverlap(OpenFile *executable, Segment *seg, int first, int count,
+	    char *buf)
+{
+    int start = first * PageSize;
+    int end = start + count * PageSize;
+
+    if (seg->size <= 0)
+	return;
+    if (seg->virtualAddr > start)
+	start = seg->virtualAddr;
+    if (seg->virtualAddr + seg->size < end)
+	end = seg->virtualAddr + seg->size;
+    if (start >= end)
+	return;
+    executable->ReadAt(&buf[start - first * PageSize], end - start,
+		       seg->inFileAddr + start - seg->virtualAddr);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReadPages
+// 	Read pages "first" to "first" + "count" - 1 of the program file
+//	into "frames", with one read per segment they overlap (usually
+//	just the one).
+//----------------------------------------------------------------------
+
+void
+AddrSpace::ReadPages(int first, int count, int *frames)
+{
+    char *buf = new char[count * PageSize];
+
+    DEBUG(dbgAddr, "Reading pages " << first << " to " << first + count - 1);
+    bzero(buf, count * PageSize);
+    ReadOverlap(executable, &noffH->code, first, count, buf);
+    ReadOverlap(executable, &noffH->initData, first, count, buf);
+#ifdef RDATA
+    ReadOverlap(executable, &noffH->readonlyData, first, count, buf);
+#endif
+    for (int i = 0; i < count; i++)
+	bcopy(&buf[i * PageSize],
+	      &kernel->machine->mainMemory[frames[i] * PageSize], PageSize);
+    delete [] buf;
+    kernel->stats->numPageIns++;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AllocRun
+// 	Return the first of kernel->superPages contiguous frames to
+//	back the pages of this space from "first" on, or -1 if the
+//	group can't be a superpage: superpages are off, the group is
+//	past the end of the space, it mixes pages of the program file
+//	(the first "filePages") with others, some of its pages are in
+//	memory already (or, for file pages, cached), or there is no
+//	such run of free frames.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::AllocRun(int first)
+{
+    int n = kernel->superPages;
+
+    if (n == 1 || first + n > basePages)
+	return -1;
+    if (first < filePages && first + n > filePages)
+	return -1;
+    for (int i = first; i < first + n; i++) {
+	if (pageTable[i].valid || (i < filePages &&
+		kernel->pageCache->IsCached(executable->HeaderSector(), i)))
+	    return -1;
+    }
+    return AllocFrames(n);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ClusterSize
+// 	How many pages of the program file to read on a fault on page
+//	"vpn": the page itself and, as far as the read-ahead window
+//	reaches, the ones after it, up to the end of the file or the
+//	first page that is in memory or cached already.  Pages ahead
+//	only go into free frames, never at the expense of cached ones.
+//
+//	The window starts at InitialCluster pages and adapts, as for
+//	sequential file reads: a fault just past the pages read last
+//	time means the program is going through them in order, and
+//	doubles it (up to MaxCluster); any other fault halves it.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::ClusterSize(int vpn)
+{
+    int file = executable->HeaderSector();
+    int count = 1;
+
+    if (vpn == nextSequential)
+	window = min(window * 2, MaxCluster);
+    else if (nextSequential != -1)	// not the first read
+	window = max(window / 2, 1);
+    while (count < window && count < NumFreePage &&
+	   vpn + count < filePages && !pageTable[vpn + count].valid &&
+	   !kernel->pageCache->IsCached(file, vpn + count))
+	count++;
+    nextSequential = vpn + count;
+    return count;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PageIn
+// 	Bring page "vpn" of the program into memory, on its first use:
+//	code and initialized data from the page cache if some process
+//	loaded it before, else read from the file along with the pages
+//	after it (see ClusterSize); the rest zero-filled.  With
+//	superpages, the whole aligned group comes in at once, into a
+//	run of contiguous frames, if it can (see AllocRun).
+//
+//	Pages read from the file are entered in the page cache, unless
+//	they went into a superpage.  Either way they are mapped
+//	read-only, copy-on-write.
+//
+//	Return FALSE if "vpn" is not a page of the program (it may be
+//	an unused stack).  If there is no frame left for it, the
+//	process exits with -1, as on Exit(-1): only it is out of luck,
+//	not the whole machine.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::PageIn(int vpn)
+{
+    int file = executable->HeaderSector();
+    int first = vpn, count = 1, run = -1;
+    int *frames;
+
+    if (vpn >= basePages)
+	return FALSE;
+    if (kernel->superPages > 1) {
+	first = vpn & ~(kernel->superPages - 1);
+	run = AllocRun(first);
+    }
+    if (run != -1) {
+	count = kernel->superPages;
+    } else if (vpn < filePages) {
+	int frame = kernel->pageCache->Lookup(file, vpn);
+
+	first = vpn;
+	if (frame != -1) {
+	    RefFrame(frame);
+	    MapPage(vpn, frame);
+	    return TRUE;
+	}
+	count = ClusterSize(vpn);
+    } else {
+	first = vpn;
+    }
+
+    frames = new int[count];
+    for (int i = 0; i < count; i++) {
+	frames[i] = (run != -1) ? run + i : AllocFrame();
+	if (frames[i] == -1) {		// out of memory
+	    while (--i >= 0)
+		FreeFrame(frames[i]);
+	    delete [] frames;
+	    cerr << "Out of memory for page " << vpn << "\n";
+	    if (pid > 0)
+		kernel->processes->Exit(pid, -1);
+	    ExitThread(-1);
+	}
+    }
+    if (first < filePages) {
+	ReadPages(first, count, frames);
+	kernel->stats->numPagesPrefetched += count - 1;
+    }
+
+    // the read may have blocked: another thread of ours may have
+    // brought some of the pages in meanwhile, or another process
+    // cached them
+    for (int i = 0; i < count; i++) {
+	if (pageTable[first + i].valid) {
+	    FreeFrame(frames[i]);
+	    continue;
+	}
+	if (run == -1 && first + i < filePages &&
+		!kernel->pageCache->IsCached(file, first + i)) {
+	    kernel->pageCache->Insert(file, first + i, frames[i]);
+	    RefFrame(frames[i]);	// and ours
+	}
+	MapPage(first + i, frames[i]);
+    }
+    delete [] frames;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::MapPage
+// 	Map page "vpn" to "frame", which holds it now; file pages
+//	read-only until written.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::MapPage(int vpn, int frame)
+{
+    pageTable[vpn].physicalPage = frame;
+    pageTable[vpn].valid = TRUE;
+    if (vpn < filePages) {
+	pageTable[vpn].readOnly = TRUE;	// until written
+	copyOnWrite[vpn] = TRUE;
+    }
+}
 
 //----------------------------------------------------------------------
 // AddrSpace::Load
@@ -106,92 +465,82 @@ AddrSpace::~AddrSpace()
 //	Assumes that the page table has been initialized, and that
 //	the object code file is in NOFF format.
 //
+//	Nothing is read yet: the pages are brought in as the program
+//	touches them (see PageIn), so the file stays open as long as
+//	the address space.
+//
 //	"fileName" is the file containing the object code to load into memory
 //----------------------------------------------------------------------
 
 bool 
 AddrSpace::Load(char *fileName) 
 {
-    OpenFile *executable = kernel->fileSystem->Open(fileName);
-    NoffHeader noffH;
-    unsigned int size;
+    unsigned int size, end;
 
+    executable = kernel->fileSystem->Open(fileName);
     if (executable == NULL) {
 	cerr << "Fail to open file " << fileName << "\n";
 	return FALSE;
     }
 
-    executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
-    if ((noffH.noffMagic != NOFFMAGIC) && 
-		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
-    	SwapHeader(&noffH);
-    ASSERT(noffH.noffMagic == NOFFMAGIC);
+    noffH = new NoffHeader;
+    executable->ReadAt((char *)noffH, sizeof(NoffHeader), 0);
+    if ((noffH->noffMagic != NOFFMAGIC) && 
+		(WordToHost(noffH->noffMagic) == NOFFMAGIC))
+    	SwapHeader(noffH);
+    ASSERT(noffH->noffMagic == NOFFMAGIC);
+
+    end = noffH->code.virtualAddr + noffH->code.size;
+    if (noffH->initData.size > 0 &&
+	    noffH->initData.virtualAddr + noffH->initData.size > end)
+	end = noffH->initData.virtualAddr + noffH->initData.size;
+#ifdef RDATA
+    if (noffH->readonlyData.size > 0 &&
+	    noffH->readonlyData.virtualAddr + noffH->readonlyData.size > end)
+	end = noffH->readonlyData.virtualAddr + noffH->readonlyData.size;
+#endif
+    filePages = divRoundUp(end, PageSize);
 
 #ifdef RDATA
 // how big is address space?
-    size = noffH.code.size + noffH.readonlyData.size + noffH.initData.size +
-           noffH.uninitData.size + UserStackSize;	
+    size = noffH->code.size + noffH->readonlyData.size +
+	   noffH->initData.size + noffH->uninitData.size + UserStackSize;	
                                                 // we need to increase the size
 						// to leave room for the stack
 #else
 // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size 
+    size = noffH->code.size + noffH->initData.size + noffH->uninitData.size 
 			+ UserStackSize;	// we need to increase the size
 						// to leave room for the stack
 #endif
     numPages = divRoundUp(size, PageSize);
+    if (numPages < (unsigned) filePages)
+	numPages = filePages;
     size = numPages * PageSize;
 
-    if(numPages > NumFreePage){
-        ExceptionHandler(MemoryLimitException);
-    }		            // check we're not trying
-						// to run anything too big --
-                        // check to be used memory not larger than remains
-    DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size);
+    DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size
+		   << ", shared " << filePages);
 
-    pageTable = new TranslationEntry[numPages];
-    for(int i = 0; i < numPages; i++){
-        int j = 0;
-        pageTable[i].virtualPage = i;
-        while(j<NumPhysPages && AddrSpace::usedPhysicalPage[j])  j++;
-
-        AddrSpace::NumFreePage--;
-        AddrSpace::usedPhysicalPage[j] = true;
-        pageTable[i].physicalPage = j;
-        pageTable[i].valid = true;
-        pageTable[i].use = false;
-        pageTable[i].dirty = false;
-        pageTable[i].readOnly = false;
-    }
-
-// then, copy in the code and data segments into memory
-// Note: this code assumes that virtual address = physical address
-    if (noffH.code.size > 0) {
-        DEBUG(dbgAddr, "Initializing code segment.");
-	DEBUG(dbgAddr, noffH.code.virtualAddr << ", " << noffH.code.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[ pageTable[noffH.code.virtualAddr/PageSize].physicalPage * PageSize + noffH.code.virtualAddr%PageSize ]), 
-			noffH.code.size, noffH.code.inFileAddr);
-    }
-    if (noffH.initData.size > 0) {
-        DEBUG(dbgAddr, "Initializing data segment.");
-	DEBUG(dbgAddr, noffH.initData.virtualAddr << ", " << noffH.initData.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[ pageTable[noffH.initData.size/PageSize].physicalPage * PageSize + noffH.initData.size%PageSize ]),
-			noffH.initData.size, noffH.initData.inFileAddr);
+    // room for the stacks of the other threads, unbacked for now
+    basePages = numPages;
+    pageTable = new TranslationEntry[basePages +
+				     (MaxUserThreads - 1) * StackPages];
+    copyOnWrite = new bool[basePages + (MaxUserThreads - 1) * StackPages];
+    for (int i = 0; i < basePages + (MaxUserThreads - 1) * StackPages; i++) {
+	pageTable[i].virtualPage = i;
+	pageTable[i].valid = false;	// until first touched
+	pageTable[i].use = false;
+	pageTable[i].dirty = false;
+	pageTable[i].readOnly = false;
+	pageTable[i].size = 1;
+	copyOnWrite[i] = false;
     }
+    numPages = basePages + (MaxUserThreads - 1) * StackPages;
+    if (debug->IsEnabled(dbgProfile))
+	profile = new PageProfile(numPages);
+    window = InitialCluster;
+    nextSequential = -1;		// nothing read yet
 
-#ifdef RDATA
-    if (noffH.readonlyData.size > 0) {
-        DEBUG(dbgAddr, "Initializing read only data segment.");
-	DEBUG(dbgAddr, noffH.readonlyData.virtualAddr << ", " << noffH.readonlyData.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[ pageTable[noffH.readonlyData.virtualAddr/PageSize].physicalPage * PageSize + noffH.readonlyData.virtualAddr%PageSize ]),
-			noffH.readonlyData.size, noffH.readonlyData.inFileAddr);
-    }
-#endif
-
-    delete executable;			// close file
     return TRUE;			// success
 }
 
@@ -209,8 +558,12 @@ AddrSpace::Execute(char* fileName)
 {
 
     kernel->currentThread->space = this;
+    slots[0].thread = kernel->currentThread;
+    slots[0].exited = FALSE;
+    slots[0].done = new Semaphore("thread done", 0);
 
     this->InitRegisters();		// set the initial register values
+    this->PushArguments();		// and main's arguments
     this->RestoreState();		// load page table register
 
     kernel->machine->Run();		// jump to the user progam
@@ -253,8 +606,8 @@ AddrSpace::InitRegisters()
    // Set the stack register to the end of the address space, where we
    // allocated the stack; but subtract off a bit, to make sure we don't
    // accidentally reference off the end!
-    machine->WriteRegister(StackReg, numPages * PageSize - 16);
-    DEBUG(dbgAddr, "Initializing stack pointer: " << numPages * PageSize - 16);
+    machine->WriteRegister(StackReg, StackTop(0));
+    DEBUG(dbgAddr, "Initializing stack pointer: " << StackTop(0));
 }
 
 //----------------------------------------------------------------------
@@ -273,11 +626,36 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table; or,
+//	if it has a TLB instead, which address space ID is ours.  The
+//	TLB keeps the entries of other spaces; they just don't match.
+//
+//	We get an ID the first time we run in each generation.  When
+//	they run out, the TLB is flushed (each entry's use and dirty
+//	bits going back to its owner) and a new generation starts, so
+//	that no two spaces share an ID in the TLB.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
+    if (kernel->machine->tlb != NULL) {
+	if (asidGeneration != generation) {
+	    if (nextASID == MaxASIDs) {
+		DEBUG(dbgAddr, "Out of address space IDs, flushing the TLB");
+		for (int i = 0; i < TLBSize; i++)
+		    EvictTLBEntry(&kernel->machine->tlb[i]);
+		for (int i = 0; i < MaxASIDs; i++)
+		    asidOwner[i] = NULL;
+		generation++;
+		nextASID = 0;
+	    }
+	    asid = nextASID++;
+	    asidGeneration = generation;
+	    asidOwner[asid] = this;
+	}
+	kernel->machine->currentASID = asid;
+	return;
+    }
     kernel->machine->pageTable = pageTable;
     kernel->machine->pageTableSize = numPages;
 }
@@ -305,6 +683,10 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 
     pte = &pageTable[vpn];
 
+    if (!pte->valid && !PageIn(vpn)) {	// a stack nobody uses
+        return AddressErrorException;
+    }
+
     if(isReadWrite && pte->readOnly) {
         return ReadOnlyException;
     }
@@ -325,7 +707,7 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 
     *paddr = pfn*PageSize + offset;
 
-    ASSERT((*paddr < MemorySize));
+    ASSERT((*paddr < (unsigned) MemorySize));
 
     //cerr << " -- AddrSpace::Translate(): vaddr: " << vaddr <<
     //  ", paddr: " << *paddr << "\n";
@@ -333,6 +715,581 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
     return NoException;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::PageFault
+// 	Called on a PageFaultException at "vaddr": bring the page into
+//	memory if the program has not used it yet (PageIn), and if the
+//	machine has a TLB, load its translation (TLBMiss), so the access
+//	can be retried.  Return FALSE if the page is not mapped at all.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::PageFault(unsigned int vaddr)
+{
+    unsigned int vpn = vaddr / PageSize;
+
+    if (vpn >= numPages)
+	return FALSE;
+    if (!pageTable[vpn].valid && !PageIn(vpn))
+	return FALSE;
+    if (profile != NULL)
+	profile->Fault(vpn);
+    if (kernel->machine->tlb != NULL)
+	return TLBMiss(vaddr);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::TLBMiss
+// 	Called on a PageFaultException at "vaddr" when the machine has
+//	a TLB and the page is in memory: load the translation of its page from the page table
+//	into the TLB, replacing an entry as kernel->tlbPolicy says (see
+//	ChooseTLBEntry), so the access can be retried.  Return FALSE if
+//	the page is not mapped at all.
+//
+//	If the page is part of an aligned group of up to
+//	kernel->superPages pages, all valid, with the same protection,
+//	and in contiguous frames aligned the same way, the entry maps
+//	the whole group.
+//----------------------------------------------------------------------
+
+static int nextTLBEntry = 0;		// the next one to replace, FIFO
+
+//----------------------------------------------------------------------
+// ChooseTLBEntry
+// 	Return the TLB entry to load a translation into: a free one if
+//	there is any, else one picked by the replacement policy.
+//	(FIFO goes round robin: every load moves on to the next entry.)
+//----------------------------------------------------------------------
+
+static int
+ChooseTLBEntry()
+{
+    TranslationEntry *tlb = kernel->machine->tlb;
+    int victim = 0;
+
+    for (int i = 0; i < TLBSize; i++) {
+	if (!tlb[i].valid)
+	    return i;
+    }
+    switch (kernel->tlbPolicy) {
+      case TLBRandom:
+	victim = RandomNumber() % TLBSize;
+	break;
+      case TLBLRU:
+	for (int i = 1; i < TLBSize; i++) {
+	    if (tlb[i].lastUse < tlb[victim].lastUse)
+		victim = i;
+	}
+	break;
+      default:
+	victim = nextTLBEntry;
+	nextTLBEntry = (nextTLBEntry + 1) % TLBSize;
+	break;
+    }
+    return victim;
+}
+
+bool
+AddrSpace::TLBMiss(unsigned int vaddr)
+{
+    TranslationEntry *entry;
+    unsigned int vpn = vaddr / PageSize;
+    int size, base;
+
+    if (kernel->machine->tlb == NULL || vpn >= numPages ||
+	    !pageTable[vpn].valid)
+	return FALSE;
+    for (size = kernel->superPages; size > 1; size /= 2) {
+	if (IsSuperPage(vpn & ~(size - 1), size))
+	    break;
+    }
+    base = vpn & ~(size - 1);
+
+    entry = &kernel->machine->tlb[ChooseTLBEntry()];
+    EvictTLBEntry(entry);
+    *entry = pageTable[base];
+    entry->size = size;
+    entry->asid = asid;
+    entry->lastUse = kernel->stats->numTLBHits;
+    DEBUG(dbgAddr, "TLB load of page " << base << ", size " << size
+		   << " -> frame " << entry->physicalPage);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SampleWorkingSet
+// 	If this space is being profiled, take a sample of its working
+//	set.  With a TLB, the use and dirty bits are set there, not in
+//	the page table: copy ours back first, and clear them too.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::SampleWorkingSet()
+{
+    TranslationEntry *tlb = kernel->machine->tlb;
+
+    if (profile == NULL)
+	return;
+    if (tlb != NULL && asidGeneration == generation) {
+	for (int i = 0; i < TLBSize; i++) {
+	    if (!tlb[i].valid || tlb[i].asid != asid)
+		continue;
+	    SaveTLBBits(&tlb[i]);
+	    tlb[i].use = FALSE;
+	}
+    }
+    profile->Sample(pid, pageTable);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SaveTLBBits
+// 	Copy the use and dirty bits of "entry", one of our TLB entries,
+//	back to the page table, for each page it maps.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::SaveTLBBits(TranslationEntry *entry)
+{
+    for (int j = 0; j < entry->size; j++) {
+	TranslationEntry *pte = &pageTable[entry->virtualPage + j];
+
+	pte->use = pte->use || entry->use;
+	pte->dirty = pte->dirty || entry->dirty;
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::EvictTLBEntry
+// 	Free TLB entry "entry" for another translation.  If it is valid,
+//	its use and dirty bits go back to the page table of the space
+//	it belongs to, whichever is running, unless that space is gone.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::EvictTLBEntry(TranslationEntry *entry)
+{
+    if (entry->valid && asidOwner[entry->asid] != NULL)
+	asidOwner[entry->asid]->SaveTLBBits(entry);
+    entry->valid = FALSE;
+}
 
+//----------------------------------------------------------------------
+// AddrSpace::IsSuperPage
+// 	Can pages "base" to "base" + "size" - 1 be mapped as one?
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::IsSuperPage(int base, int size)
+{
+    int frame = pageTable[base].physicalPage;
+
+    if (base + size > (int) numPages || frame % size != 0)
+	return FALSE;
+    for (int i = base; i < base + size; i++) {
+	if (!pageTable[i].valid ||
+		pageTable[i].physicalPage != frame + (i - base) ||
+		pageTable[i].readOnly != pageTable[base].readOnly)
+	    return FALSE;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::InvalidateTLB
+// 	Page "vpn" changed its mapping: drop any TLB entry covering it,
+//	keeping its use and dirty bits.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::InvalidateTLB(int vpn)
+{
+    TranslationEntry *tlb = kernel->machine->tlb;
+
+    if (tlb == NULL || asidGeneration != generation)
+	return;				// none of ours in there
+    for (int i = 0; i < TLBSize; i++) {
+	if (tlb[i].valid && tlb[i].asid == asid &&
+		tlb[i].virtualPage == (vpn & ~(tlb[i].size - 1)))
+	    EvictTLBEntry(&tlb[i]);
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyIn, AddrSpace::CopyOut
+// 	Copy "size" bytes between virtual address "vaddr" of this space
+//	and the kernel buffer "buf", for system calls.  The pages of the
+//	user buffer need not be contiguous in physical memory: each page
+//	is translated once and its part copied in one go.  CopyOut
+//	breaks copy-on-write sharing as a user store would.
+//
+//	Return FALSE if part of the buffer is not mapped (or not
+//	writable, for CopyOut); some of it may have been copied.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyIn(unsigned int vaddr, char *buf, int size)
+{
+    unsigned int paddr;
 
+    while (size > 0) {
+	int chunk = PageSize - vaddr % PageSize;
 
+	if (chunk > size)
+	    chunk = size;
+	if (Translate(vaddr, &paddr, 0) != NoException)
+	    return FALSE;
+	memcpy(buf, &kernel->machine->mainMemory[paddr], chunk);
+	vaddr += chunk;
+	buf += chunk;
+	size -= chunk;
+    }
+    return TRUE;
+}
+
+bool
+AddrSpace::CopyOut(unsigned int vaddr, char *buf, int size)
+{
+    unsigned int paddr;
+
+    while (size > 0) {
+	int chunk = PageSize - vaddr % PageSize;
+	ExceptionType result;
+
+	if (chunk > size)
+	    chunk = size;
+	result = Translate(vaddr, &paddr, 1);
+	if (result == ReadOnlyException && CopyOnWrite(vaddr))
+	    result = Translate(vaddr, &paddr, 1);
+	if (result != NoException)
+	    return FALSE;
+	memcpy(&kernel->machine->mainMemory[paddr], buf, chunk);
+	vaddr += chunk;
+	buf += chunk;
+	size -= chunk;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyInString
+// 	Copy the null-terminated string at virtual address "vaddr" into
+//	a new kernel buffer, scanning a page at a time.  Return NULL if
+//	it is not mapped, or longer than "max" characters.
+//----------------------------------------------------------------------
+
+char *
+AddrSpace::CopyInString(unsigned int vaddr, int max)
+{
+    char *buf = new char[max + 1];
+    unsigned int paddr;
+    int len = 0;
+
+    while (len <= max) {
+	int chunk = PageSize - vaddr % PageSize;
+	char *end;
+
+	if (chunk > max + 1 - len)
+	    chunk = max + 1 - len;
+	if (Translate(vaddr, &paddr, 0) != NoException)
+	    break;
+	end = (char *) memchr(&kernel->machine->mainMemory[paddr], 0, chunk);
+	if (end != NULL) {
+	    memcpy(&buf[len], &kernel->machine->mainMemory[paddr],
+		   end - &kernel->machine->mainMemory[paddr] + 1);
+	    return buf;
+	}
+	memcpy(&buf[len], &kernel->machine->mainMemory[paddr], chunk);
+	vaddr += chunk;
+	len += chunk;
+    }
+    delete [] buf;
+    return NULL;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// AddrSpace::StackTop
+// 	Return the initial stack pointer of thread slot "tid": the end of
+//	the program's stack for slot 0, the end of the slot's own stack
+//	region for the others.  As for the program, subtract off a bit.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::StackTop(int tid)
+{
+    return (basePages + tid * StackPages) * PageSize - 16;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AllocStack, AddrSpace::FreeStack
+// 	Back the stack region of thread slot "tid" (> 0) with physical
+//	pages, or give them back.  AllocStack returns FALSE if there is
+//	not enough free memory.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::AllocStack(int tid)
+{
+    int first = basePages + (tid - 1) * StackPages;
+
+    ASSERT(tid > 0 && tid < MaxUserThreads);
+    if (StackPages > NumFreePage)
+	return FALSE;
+    for (int i = first; i < first + StackPages; i++) {
+	pageTable[i].physicalPage = AllocFrame();
+	pageTable[i].valid = true;
+	pageTable[i].use = false;
+	pageTable[i].dirty = false;
+    }
+    return TRUE;
+}
+
+void
+AddrSpace::FreeStack(int tid)
+{
+    int first = basePages + (tid - 1) * StackPages;
+
+    ASSERT(tid > 0 && tid < MaxUserThreads);
+    for (int i = first; i < first + StackPages; i++) {
+	if (!pageTable[i].valid)
+	    continue;
+	FreeFrame(pageTable[i].physicalPage);
+	pageTable[i].valid = false;
+	InvalidateTLB(i);
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CurrentSlot
+// 	Return the slot of the current thread, which must be running in
+//	this address space.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::CurrentSlot()
+{
+    for (int i = 0; i < MaxUserThreads; i++) {
+	if (slots[i].thread == kernel->currentThread && !slots[i].exited)
+	    return i;
+    }
+    ASSERTNOTREACHED();
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ForkThread
+// 	Start a thread running user routine "func" in this address space,
+//	on a stack of its own.  It gets the priority of its creator.
+//
+//	Returns its slot, which is the ThreadId the user program sees,
+//	or -1 if all slots are in use (threads that exited but were not
+//	joined yet still hold theirs) or memory is short.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::ForkThread(int func)
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    Thread *parent = kernel->currentThread;
+    Thread *thread;
+    int tid;
+
+    for (tid = 1; tid < MaxUserThreads; tid++) {
+	if (slots[tid].thread == NULL)
+	    break;
+    }
+    if (tid == MaxUserThreads || !AllocStack(tid)) {
+	(void) kernel->interrupt->SetLevel(oldLevel);
+	return -1;
+    }
+    thread = new Thread(parent->getName(), kernel->NewThreadID(),
+			parent->basePriority);
+    kernel->predictor->Seed(thread);
+    thread->space = this;
+    numThreads++;
+    slots[tid].thread = thread;
+    slots[tid].func = func;
+    slots[tid].exited = FALSE;
+    if (slots[tid].done == NULL)
+	slots[tid].done = new Semaphore("thread done", 0);
+    DEBUG(dbgAddr, "Forking user thread " << tid << " at " << func
+		   << ", stack " << StackTop(tid));
+    thread->Fork((VoidFunctionPtr) &AddrSpace::ThreadRoot, (void *) thread);
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    return tid;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ThreadRoot
+// 	The first thing a thread made by ForkThread runs: set up its
+//	registers to call the user routine on its own stack, and jump
+//	to user code.
+//
+//	The routine must end by calling ThreadExit (or Exit); there is
+//	nowhere for it to return to.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::ThreadRoot(Thread *thread)
+{
+    AddrSpace *space = thread->space;
+    Machine *machine = kernel->machine;
+    int tid = space->CurrentSlot();
+
+    space->InitRegisters();
+    machine->WriteRegister(PCReg, space->slots[tid].func);
+    machine->WriteRegister(NextPCReg, space->slots[tid].func + 4);
+    machine->WriteRegister(StackReg, space->StackTop(tid));
+    space->RestoreState();		// load page table register
+
+    machine->Run();			// jump to the user routine
+    ASSERTNOTREACHED();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::JoinThread
+// 	Wait for thread "tid" of this address space to call ThreadExit,
+//	then free its slot.  Returns its exit code, or -1 if there is no
+//	such thread, or it is the current one.  Only one thread may wait
+//	for a given thread.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::JoinThread(int tid)
+{
+    int exitCode;
+
+    if (tid < 0 || tid >= MaxUserThreads || slots[tid].thread == NULL)
+	return -1;
+    if (!slots[tid].exited && slots[tid].thread == kernel->currentThread)
+	return -1;			// would wait forever
+    slots[tid].done->P();
+    exitCode = slots[tid].exitCode;
+    slots[tid].thread = NULL;		// the slot can be reused
+    return exitCode;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ExitThread
+// 	End the current thread, leaving "exitCode" for whoever joins it.
+//	Its stack goes back to the free pages right away: the rest of
+//	Finish runs on the kernel stack.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::ExitThread(int exitCode)
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    int tid = CurrentSlot();
+
+    DEBUG(dbgAddr, "User thread " << tid << " exits with " << exitCode);
+    slots[tid].exited = TRUE;
+    slots[tid].exitCode = exitCode;
+    if (tid > 0)
+	FreeStack(tid);
+    slots[tid].done->V();
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    kernel->currentThread->Finish();
+    ASSERTNOTREACHED();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CopyOnWrite
+// 	Called on a ReadOnlyException at "vaddr": if the page is shared
+//	copy-on-write, give this space a private, writable copy (or just
+//	make it writable, if nobody else maps the frame any more), so
+//	the write can be retried.  Returns FALSE if the page is really
+//	read-only, or there is no free frame to copy to.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyOnWrite(unsigned int vaddr)
+{
+    unsigned int vpn = vaddr / PageSize;
+    TranslationEntry *pte;
+    int frame;
+
+    if (vpn >= numPages || !pageTable[vpn].valid || !copyOnWrite[vpn])
+	return FALSE;
+    pte = &pageTable[vpn];
+    frame = pte->physicalPage;
+    if (frameRefs[frame] > 1) {
+	int copy = AllocFrame();
+
+	if (copy < 0)
+	    return FALSE;
+	bcopy(&kernel->machine->mainMemory[frame * PageSize],
+	      &kernel->machine->mainMemory[copy * PageSize], PageSize);
+	FreeFrame(frame);
+	pte->physicalPage = copy;
+    }
+    DEBUG(dbgAddr, "Copy on write of page " << vpn << ", frame " << frame
+		   << " -> " << pte->physicalPage);
+    pte->readOnly = FALSE;
+    copyOnWrite[vpn] = FALSE;
+    kernel->stats->numCopyOnWrites++;
+    if (profile != NULL)
+	profile->CopyOnWrite(vpn);
+    InvalidateTLB(vpn);			// drop the stale translation
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SetArguments, AddrSpace::PushArguments
+// 	Arrange for main() of the program to be called with "argc" and
+//	"argv" (ExecV).  The strings are copied now; once the program
+//	starts, PushArguments puts them at the top of its stack,
+//	followed by the argv array, and points r4, r5 and the stack
+//	pointer below them.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::SetArguments(int count, char **args)
+{
+    argc = count;
+    argv = new char *[argc];
+    for (int i = 0; i < argc; i++) {
+	argv[i] = new char[strlen(args[i]) + 1];
+	strcpy(argv[i], args[i]);
+    }
+}
+
+void
+AddrSpace::PushArguments()
+{
+    Machine *machine = kernel->machine;
+    int sp = StackTop(0) + 16;		// the very top of the stack
+    int argvAddr;
+    int *addrs;
+    bool copied;
+
+    if (argc == 0)
+	return;
+    addrs = new int[argc];
+    for (int i = 0; i < argc; i++) {
+	int len = strlen(argv[i]) + 1;
+
+	sp -= len;
+	copied = CopyOut(sp, argv[i], len);
+	ASSERT(copied);			// the stack is always mapped
+	addrs[i] = sp;
+    }
+    sp &= ~3;				// word aligned
+    sp -= argc * 4;
+    argvAddr = sp;
+    for (int i = 0; i < argc; i++)
+	addrs[i] = WordToMachine(addrs[i]);
+    copied = CopyOut(argvAddr, (char *) addrs, argc * 4);
+    ASSERT(copied);
+    delete [] addrs;
+
+    machine->WriteRegister(4, argc);
+    machine->WriteRegister(5, argvAddr);
+    machine->WriteRegister(StackReg, sp - 16);
+    DEBUG(dbgAddr, "Passing " << argc << " arguments, stack pointer "
+		   << sp - 16);
+}
@@ -2,10 +2,31 @@
 //	Data structures to keep track of executing user programs
 //	(address spaces).
 //
-//	For now, we don't keep any information about address spaces.
 //	The user level CPU state is saved and restored in the thread
 //	executing the user program (see thread.h).
 //
+//	Several threads can run in one address space (ThreadFork).
+//	Each has a user stack of its own, carved out of the space above
+//	the program's: slot 0 is the thread that loaded the program,
+//	the others get UserStackSize bytes at the top of the space, one
+//	region per slot.  A stack is only backed by physical memory
+//	while its thread is alive.
+//
+//	The pages of the program are brought into memory when they are
+//	first touched (demand paging), several at a time if the program
+//	seems to be going through them in order (see ClusterSize).
+//
+//	If the machine has a TLB, it is refilled from the page table on
+//	each miss (TLBMiss).  Its entries are tagged with an address
+//	space ID, so a context switch need not flush it.
+//
+//	Processes running the same program share the frames holding its
+//	code and initialized data (kept in the page cache, pagecache.h),
+//	copy-on-write: those pages are mapped read-only, and the first
+//	write to one gets the process a private copy (see CopyOnWrite).
+//	Frames are reference counted, and go back to the free pool with
+//	the last mapping.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
@@ -19,6 +40,32 @@
 
 #define UserStackSize 1024 // increase this as necessary!
 
+const int MaxUserThreads = 8; // threads per address space, including
+                              // the one that loaded the program
+
+const int MaxASIDs = 64; // address space IDs the TLB tells apart
+
+// How the TLB is run (-tlb): not at all (the machine walks the page
+// table), or refilled by the kernel, replacing entries at random, in
+// the order they were loaded, or least recently used first.
+
+enum TLBPolicy { TLBOff, TLBRandom, TLBFifo, TLBLRU };
+
+class PageProfile;
+class Semaphore;
+class Thread;
+
+// The following class records one thread of an address space.
+
+class ThreadSlot {
+public:
+  Thread *thread;  // NULL if the slot is free
+  int func;        // user routine the thread runs
+  bool exited;     // did it call ThreadExit?
+  int exitCode;    // if so, with what
+  Semaphore *done; // signalled on ThreadExit, for ThreadJoin
+};
+
 class AddrSpace {
 public:
   AddrSpace();  // Create an address space.
@@ -35,7 +82,41 @@ public:
   void SaveState();    // Save/restore address space-specific
   void RestoreState(); // info on a context switch
 
-  static bool usedPhysicalPage[NumPhysPages];
+  int ForkThread(int func); // Run user routine "func" in a new
+                            // thread; return its slot, or -1
+  int JoinThread(int tid);  // Wait for thread "tid" to exit, and
+                            // return its exit code, or -1
+  void ExitThread(int exitCode); // End the current thread
+
+  bool PageFault(unsigned int vaddr); // Handle a PageFaultException at
+                                      // "vaddr"; FALSE if the page is
+                                      // not mapped
+  bool CopyOnWrite(unsigned int vaddr); // Handle a ReadOnlyException
+                                        // at "vaddr"; FALSE if the page
+                                        // is really read-only
+  void SetArguments(int argc, char **argv); // Pass these to main()
+
+  bool CopyIn(unsigned int vaddr, char *buf, int size);  // Copy between
+  bool CopyOut(unsigned int vaddr, char *buf, int size); // user memory
+                                                         // and the kernel
+  char *CopyInString(unsigned int vaddr, int max); // new copy of a user
+                                                   // string, or NULL
+  void SampleWorkingSet(); // on a timer interrupt, if profiling
+
+  int pid;        // SpaceId in kernel->processes, or 0
+  int numThreads; // threads using this space; the last one to
+                  // be destroyed deletes it (see Thread::~Thread)
+
+  static int AllocFrame();         // Take a zeroed free frame, or -1
+  static int AllocFrames(int n);   // ... or n contiguous ones
+  static void RefFrame(int frame); // Map a frame once more
+  static void FreeFrame(int frame); // Unmap it; free it if last
+
+  static void InitFrames();        // Size the frame tables to
+  static void DeleteFrames();      // NumPhysPages, or free them
+
+  static bool *usedPhysicalPage;
+  static int *frameRefs; // mappings of each frame
   static int NumFreePage;
 
   // Translate virtual address _vaddr_.
@@ -48,9 +129,43 @@ private:
                                // for now!
   unsigned int numPages;       // Number of pages in the virtual
                                // address space
+  int basePages;               // of which the program and its stack
+  int filePages;               // of which code and initialized data
+  OpenFile *executable;        // the program, to page in from
+  struct noffHeader *noffH;    // and its header
+  int window;                  // pages to read per fault, at most
+  int nextSequential;          // the page after those read last, or -1
+  bool *copyOnWrite;           // per page: shared until written?
+  PageProfile *profile;        // NULL unless the 'p' flag is on
+  int argc;                    // SetArguments, for InitRegisters
+  char **argv;
+  ThreadSlot slots[MaxUserThreads];
 
   void InitRegisters(); // Initialize user-level CPU registers,
                         // before jumping to user code
+  int StackTop(int tid); // Initial stack pointer of slot "tid"
+  bool AllocStack(int tid); // Back the stack of slot "tid" with
+  void FreeStack(int tid);  // physical pages, or release them
+  int CurrentSlot();        // slot of the current thread
+  void PushArguments();     // put argc and argv on the stack
+  bool PageIn(int vpn);      // bring page "vpn" into memory
+  void MapPage(int vpn, int frame); // ... and map it
+  void ReadPages(int first, int count, int *frames); // from the file
+  int ClusterSize(int vpn); // pages to read on a fault on "vpn"
+  int AllocRun(int first);  // frames for a superpage at "first", or -1
+  bool TLBMiss(unsigned int vaddr); // load the TLB for "vaddr"
+  bool IsSuperPage(int base, int size); // can the TLB map these as one?
+  void InvalidateTLB(int vpn); // page "vpn" is mapped differently now
+  void SaveTLBBits(TranslationEntry *entry); // use, dirty of our entry
+  static void EvictTLBEntry(TranslationEntry *entry); // before reuse
+
+  int asid;                 // tags our TLB entries, if asidGeneration
+  int asidGeneration;       // is the current one
+  static int generation;    // bumped when the IDs run out
+  static int nextASID;      // the next free one in this generation
+  static AddrSpace *asidOwner[MaxASIDs]; // who has each, or NULL
+
+  static void ThreadRoot(Thread *thread); // where forked threads start
 };
 
 #endif // ADDRSPACE_H
@@ -25,6 +25,428 @@
 #include "main.h"
 #include "syscall.h"
 #include "ksyscall.h"
+
+const int MaxExecArgs = 16;	// ExecV arguments
+const int MaxIoVecs = 16;	// ReadV and WriteV pieces
+const int MaxUserString = 128;	// length of a file name, argument or
+				// message passed by a user program
+
+// The following class describes one system call, for the dispatcher
+// in ExceptionHandler.  The handler gets the arguments from r4..r7 in
+// arg[]; those flagged in "stringArgs" are user addresses of strings,
+// which are copied in first and passed in str[] (the handler may keep
+// one by setting its entry to NULL; the others are freed).  Its
+// return value goes to r2.
+
+typedef int (*SyscallHandler)(int *arg, char **str);
+
+class SyscallEntry {
+  public:
+    int code;			// SC_xxx, see syscall.h
+    const char *name;		// for statistics and debugging
+    SyscallHandler handler;
+    int numArgs;		// how many of r4..r7 it takes
+    int stringArgs;		// bit i set: arg i is a user string
+    int failValue;		// result if one of them can't be read
+};
+
+const int MaxSyscallArgs = 4;
+const int Str0 = 1, Str1 = 2;	// stringArgs bits
+
+//----------------------------------------------------------------------
+// Handlers for the system calls: unpack the arguments for the
+// Sys... routines in ksyscall.h.
+//----------------------------------------------------------------------
+
+static int
+DoHalt(int *arg, char **str)
+{
+    DEBUG(dbgSys, "Shutdown, initiated by user program.\n");
+    SysHalt();
+    ASSERTNOTREACHED();
+    return 0;
+}
+
+static int
+DoExit(int *arg, char **str)
+{
+    DEBUG(dbgAddr, "Program exit\n");
+    kernel->synchConsoleOut->Drain();	// what it wrote comes first
+    cout << "return value:" << arg[0] << endl;
+    SysExit(arg[0]);
+    ASSERTNOTREACHED();
+    return 0;
+}
+
+static int
+DoExec(int *arg, char **str)
+{
+    DEBUG(dbgSys, "Exec " << str[0] << "\n");
+    int result = SysExec(str[0]);
+
+    if (result >= 0)
+	str[0] = NULL;			// it names the new thread
+    return result;
+}
+
+static int
+DoExecV(int *arg, char **str)
+{
+    int argc = arg[0];
+    int args[MaxExecArgs];
+    char *argv[MaxExecArgs];
+    int i = 0, result = -1;
+
+    if (argc > 0 && argc <= MaxExecArgs &&
+	    kernel->currentThread->space->CopyIn(arg[1], (char *) args,
+						 argc * 4)) {
+	for (; i < argc; i++) {
+	    argv[i] = kernel->currentThread->space->CopyInString(
+		    WordToHost(args[i]), MaxUserString);
+	    if (argv[i] == NULL)
+		break;
+	}
+    }
+    if (argc > 0 && i == argc) {
+	DEBUG(dbgSys, "ExecV " << argv[0] << ", " << argc << " args\n");
+	result = SysExecV(argc, argv);
+	// if the Exec worked, argv[0] names the new thread
+	for (i = (result >= 0) ? 1 : 0; i < argc; i++)
+	    delete [] argv[i];
+    } else {
+	while (--i >= 0)
+	    delete [] argv[i];
+    }
+    return result;
+}
+
+static int
+DoJoin(int *arg, char **str)
+{
+    DEBUG(dbgSys, "Join " << arg[0] << "\n");
+    return SysJoin(arg[0]);
+}
+
+static int
+DoCreate(int *arg, char **str)
+{
+    return SysCreate(str[0]);
+}
+
+static int
+DoOpen(int *arg, char **str)
+{
+    return SysOpen(str[0]);
+}
+
+static int
+DoRead(int *arg, char **str)
+{
+    int size = arg[1];
+    int numChar = -1;
+    char *buf;
+
+    if (size >= 0 && size <= MemorySize) {
+	buf = new char[size];
+	numChar = SysRead(buf, size, arg[2]);
+	if (numChar > 0 &&
+		!kernel->currentThread->space->CopyOut(arg[0], buf, numChar))
+	    numChar = -1;
+	delete [] buf;
+    }
+    return numChar;
+}
+
+static int
+DoWrite(int *arg, char **str)
+{
+    int size = arg[1];
+    int numChar = -1;
+    char *buf;
+
+    if (size >= 0 && size <= MemorySize) {
+	buf = new char[size];
+	if (kernel->currentThread->space->CopyIn(arg[0], buf, size))
+	    numChar = SysWrite(buf, size, arg[2]);
+	delete [] buf;
+    }
+    return numChar;
+}
+
+//----------------------------------------------------------------------
+// ReadIoVecs
+// 	Copy in the "count" IoVecs at user address "addr", for ReadV and
+//	WriteV.  Return the total length of the pieces, or -1 if the
+//	array can't be read or is too long (in count or in bytes).
+//----------------------------------------------------------------------
+
+static int
+ReadIoVecs(int addr, int count, int *base, int *len)
+{
+    int iov[MaxIoVecs * 2];
+    int total = 0;
+
+    if (count < 0 || count > MaxIoVecs ||
+	    !kernel->currentThread->space->CopyIn(addr, (char *) iov,
+						 count * 8))
+	return -1;
+    for (int i = 0; i < count; i++) {
+	base[i] = WordToHost(iov[2 * i]);
+	len[i] = WordToHost(iov[2 * i + 1]);
+	if (len[i] < 0 || len[i] > MemorySize - total)
+	    return -1;
+	total += len[i];
+    }
+    return total;
+}
+
+static int
+DoReadV(int *arg, char **str)
+{
+    int base[MaxIoVecs], len[MaxIoVecs];
+    int total = ReadIoVecs(arg[0], arg[1], base, len);
+    int numChar, done = 0;
+    char *buf;
+
+    if (total < 0)
+	return -1;
+    buf = new char[total];
+    numChar = SysRead(buf, total, arg[2]);
+    for (int i = 0; i < arg[1] && done < numChar; i++) {
+	int chunk = min(len[i], numChar - done);
+
+	if (!kernel->currentThread->space->CopyOut(base[i], buf + done,
+						   chunk)) {
+	    numChar = -1;
+	    break;
+	}
+	done += chunk;
+    }
+    delete [] buf;
+    return numChar;
+}
+
+static int
+DoWriteV(int *arg, char **str)
+{
+    int base[MaxIoVecs], len[MaxIoVecs];
+    int total = ReadIoVecs(arg[0], arg[1], base, len);
+    int numChar = -1, done = 0;
+    char *buf;
+
+    if (total < 0)
+	return -1;
+    buf = new char[total];
+    for (int i = 0; i < arg[1]; i++) {
+	if (!kernel->currentThread->space->CopyIn(base[i], buf + done,
+						  len[i]))
+	    break;
+	done += len[i];
+    }
+    if (done == total)
+	numChar = SysWrite(buf, total, arg[2]);
+    delete [] buf;
+    return numChar;
+}
+
+static int
+DoReadLine(int *arg, char **str)
+{
+    int size = arg[1];
+    int numChar = -1;
+    char *buf;
+
+    if (size >= 0 && size <= MemorySize) {
+	buf = new char[size];
+	numChar = SysReadLine(buf, size);
+	if (numChar > 0 &&
+		!kernel->currentThread->space->CopyOut(arg[0], buf, numChar))
+	    numChar = -1;
+	delete [] buf;
+    }
+    return numChar;
+}
+
+static int
+DoClose(int *arg, char **str)
+{
+    return SysClose(arg[0]);
+}
+
+static int
+DoThreadFork(int *arg, char **str)
+{
+    DEBUG(dbgSys, "ThreadFork " << arg[0] << "\n");
+    return SysThreadFork(arg[0]);
+}
+
+static int
+DoThreadYield(int *arg, char **str)
+{
+    DEBUG(dbgSys, "ThreadYield\n");
+    SysThreadYield();
+    return 0;
+}
+
+static int
+DoThreadExit(int *arg, char **str)
+{
+    DEBUG(dbgSys, "ThreadExit " << arg[0] << "\n");
+    SysThreadExit(arg[0]);
+    ASSERTNOTREACHED();
+    return 0;
+}
+
+static int
+DoThreadJoin(int *arg, char **str)
+{
+    DEBUG(dbgSys, "ThreadJoin " << arg[0] << "\n");
+    return SysThreadJoin(arg[0]);
+}
+
+static int
+DoPrintInt(int *arg, char **str)
+{
+    DEBUG(dbgSys, "Print Int\n");
+    DEBUG(dbgTraCode, "In ExceptionHandler(), into SysPrintInt, " << kernel->stats->totalTicks);    
+    SysPrintInt(arg[0]);
+    DEBUG(dbgTraCode, "In ExceptionHandler(), return from SysPrintInt, " << kernel->stats->totalTicks);
+    return 0;
+}
+
+static int
+DoSleep(int *arg, char **str)
+{
+    DEBUG(dbgSys, "Sleep " << arg[0] << "\n");
+    SysSleep(arg[0]);
+    return 0;
+}
+
+static int
+DoAdd(int *arg, char **str)
+{
+    int result;
+
+    DEBUG(dbgSys, "Add " << arg[0] << " + " << arg[1] << "\n");
+    result = SysAdd(arg[0], arg[1]);
+    DEBUG(dbgSys, "Add returning with " << result << "\n");
+    kernel->synchConsoleOut->Drain();
+    cout << "result is " << result << "\n";	
+    return result;
+}
+
+static int
+DoMSG(int *arg, char **str)
+{
+    char *msg;
+
+    DEBUG(dbgSys, "Message received.\n");
+    msg = kernel->currentThread->space->CopyInString(arg[0], MaxUserString);
+    kernel->synchConsoleOut->Drain();
+    if (msg != NULL)
+	cout << msg << endl;
+    delete [] msg;
+    SysHalt();
+    ASSERTNOTREACHED();
+    return 0;
+}
+
+// The system calls we implement.  SC_Remove and SC_Seek are not
+// among them.
+
+static SyscallEntry syscallList[] = {
+    { SC_Halt,		"Halt",		DoHalt,		0, 0,	 0 },
+    { SC_Exit,		"Exit",		DoExit,		1, 0,	 0 },
+    { SC_Exec,		"Exec",		DoExec,		1, Str0, -1 },
+    { SC_Join,		"Join",		DoJoin,		1, 0,	 0 },
+    { SC_Create,	"Create",	DoCreate,	1, Str0, 0 },
+    { SC_Open,		"Open",		DoOpen,		1, Str0, -1 },
+    { SC_Read,		"Read",		DoRead,		3, 0,	 0 },
+    { SC_Write,		"Write",	DoWrite,	3, 0,	 0 },
+    { SC_Close,		"Close",	DoClose,	1, 0,	 0 },
+    { SC_ReadV,		"ReadV",	DoReadV,	3, 0,	 0 },
+    { SC_WriteV,	"WriteV",	DoWriteV,	3, 0,	 0 },
+    { SC_ReadLine,	"ReadLine",	DoReadLine,	2, 0,	 0 },
+    { SC_ThreadFork,	"ThreadFork",	DoThreadFork,	1, 0,	 0 },
+    { SC_ThreadYield,	"ThreadYield",	DoThreadYield,	0, 0,	 0 },
+    { SC_ExecV,		"ExecV",	DoExecV,	2, 0,	 0 },
+    { SC_ThreadExit,	"ThreadExit",	DoThreadExit,	1, 0,	 0 },
+    { SC_ThreadJoin,	"ThreadJoin",	DoThreadJoin,	1, 0,	 0 },
+    { SC_PrintInt,	"PrintInt",	DoPrintInt,	1, 0,	 0 },
+    { SC_Sleep,		"Sleep",	DoSleep,	1, 0,	 0 },
+    { SC_Add,		"Add",		DoAdd,		2, 0,	 0 },
+    { SC_MSG,		"MSG",		DoMSG,		1, 0,	 0 },
+};
+
+// syscallList, indexed by code; built on the first system call
+static SyscallEntry *syscallTable[MaxSyscalls];
+static bool syscallTableBuilt = FALSE;
+
+static void
+BuildSyscallTable()
+{
+    for (unsigned i = 0; i < sizeof(syscallList) / sizeof(syscallList[0]);
+	 i++) {
+	ASSERT(syscallList[i].code < MaxSyscalls &&
+	       syscallTable[syscallList[i].code] == NULL);
+	syscallTable[syscallList[i].code] = &syscallList[i];
+    }
+    syscallTableBuilt = TRUE;
+}
+
+//----------------------------------------------------------------------
+// DoSyscall
+// 	Carry out system call "type" for the current user program: look
+//	it up in syscallTable, advance the PC past the syscall
+//	instruction (first, since the call may block or yield for a
+//	while), copy in its string arguments, call the handler, and put
+//	the result in r2.  The call and the ticks until it returns are
+//	counted in kernel->stats.
+//----------------------------------------------------------------------
+
+static void
+DoSyscall(int type)
+{
+    Machine *machine = kernel->machine;
+    SyscallEntry *entry;
+    int arg[MaxSyscallArgs];
+    char *str[MaxSyscallArgs];
+    int start = kernel->stats->totalTicks;
+    int result;
+    bool ok = TRUE;
+
+    if (!syscallTableBuilt)
+	BuildSyscallTable();
+    entry = (type >= 0 && type < MaxSyscalls) ? syscallTable[type] : NULL;
+    if (entry == NULL) {
+	cerr << "Unexpected system call " << type << "\n";
+	ASSERTNOTREACHED();
+    }
+    kernel->stats->numSyscalls[type]++;
+    kernel->stats->syscallName[type] = entry->name;
+
+    for (int i = 0; i < entry->numArgs; i++) {
+	arg[i] = machine->ReadRegister(4 + i);
+	str[i] = NULL;
+	if (ok && (entry->stringArgs & (1 << i))) {
+	    str[i] = kernel->currentThread->space->CopyInString(arg[i],
+							       MaxUserString);
+	    ok = (str[i] != NULL);
+	}
+    }
+
+    machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
+    machine->WriteRegister(PCReg, machine->ReadRegister(PCReg) + 4);
+    machine->WriteRegister(NextPCReg, machine->ReadRegister(PCReg) + 4);
+
+    result = ok ? (*entry->handler)(arg, str) : entry->failValue;
+    machine->WriteRegister(2, result);
+
+    for (int i = 0; i < entry->numArgs; i++)
+	delete [] str[i];
+    kernel->stats->syscallTicks[type] += kernel->stats->totalTicks - start;
+}
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -43,6 +465,7 @@
 //
 // If you are handling a system call, don't forget to increment the pc
 // before returning. (Or else you'll loop making the same system call forever!)
+// (DoSyscall does both, for every system call in syscallList.)
 //
 //	"which" is the kind of exception.  The list of possible exceptions 
 //	is in machine.h.
@@ -50,168 +473,30 @@
 void
 ExceptionHandler(ExceptionType which)
 {
-    char ch;
     int val;
     int type = kernel->machine->ReadRegister(2);
-    int status, exit, threadID, programID, fileID, numChar;
-	char *filename, *buf;
     DEBUG(dbgSys, "Received Exception " << which << " type: " << type << "\n");
     DEBUG(dbgTraCode, "In ExceptionHandler(), Received Exception " << which << " type: " << type << ", " << kernel->stats->totalTicks);
     switch (which) {
     case SyscallException:
-	switch(type) {
-	    case SC_Halt:
-		DEBUG(dbgSys, "Shutdown, initiated by user program.\n");
-		SysHalt();
-		cout<<"in exception\n";
-		ASSERTNOTREACHED();
-	    break;
-	    case SC_PrintInt:
-		DEBUG(dbgSys, "Print Int\n");
-		val=kernel->machine->ReadRegister(4);
-		DEBUG(dbgTraCode, "In ExceptionHandler(), into SysPrintInt, " << kernel->stats->totalTicks);    
-		SysPrintInt(val); 	
-		DEBUG(dbgTraCode, "In ExceptionHandler(), return from SysPrintInt, " << kernel->stats->totalTicks);
-		// Set Program Counter
-		kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-		kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-		kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-		return;
-		ASSERTNOTREACHED();
-	    break;
-	    case SC_MSG:
-		DEBUG(dbgSys, "Message received.\n");
-		val = kernel->machine->ReadRegister(4);
-		{
-		char *msg = &(kernel->machine->mainMemory[val]);
-		cout << msg << endl;
-		}
-		SysHalt();
-		ASSERTNOTREACHED();
-	    break;
-	    case SC_Create:
-		val = kernel->machine->ReadRegister(4);
-		{
-		filename = &(kernel->machine->mainMemory[val]);
-		//cout << filename << endl;
-		status = SysCreate(filename);
-		kernel->machine->WriteRegister(2, (int) status);
-		}
-		kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-		kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-		kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-		return;
-		ASSERTNOTREACHED();
-	    break;
-      	case SC_Add:
-		DEBUG(dbgSys, "Add " << kernel->machine->ReadRegister(4) << " + " << kernel->machine->ReadRegister(5) << "\n");
-		/* Process SysAdd Systemcall*/
-		int result;
-		result = SysAdd(/* int op1 */(int)kernel->machine->ReadRegister(4),
-		/* int op2 */(int)kernel->machine->ReadRegister(5));
-		DEBUG(dbgSys, "Add returning with " << result << "\n");
-		/* Prepare Result */
-		kernel->machine->WriteRegister(2, (int)result);	
-		/* Modify return point */
-		{
-		/* set previous programm counter (debugging only)*/
-		kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-			
-		/* set programm counter to next instruction (all Instructions are 4 byte wide)*/
-		kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-	  
-		/* set next programm counter for brach execution */
-		kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-		}
-		cout << "result is " << result << "\n";	
-		return;	
-		ASSERTNOTREACHED();
-	    	break;
-	case SC_Open:
-		DEBUG(dbgSys, "exception SC_Open begin \n");
-		val = kernel->machine->ReadRegister(4);
-		filename = &(kernel->machine->mainMemory[val]);
-		fileID = SysOpen(filename);
-		kernel->machine->WriteRegister(2, (int)fileID);
-		{
-		kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-		kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg)+4);
-		kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-		}
-		DEBUG(dbgSys, "exception SC_Open end \n");
-		return;
-		ASSERTNOTREACHED();
-		break;
-		//finish open at 10.21 2:57		
-	case SC_Read:
-		val = kernel->machine->ReadRegister(4);
-		filename = &(kernel->machine->mainMemory[val]);
-		numChar = SysRead(filename, kernel->machine->ReadRegister(5), kernel->machine->ReadRegister(6));
-		kernel->machine->WriteRegister(2, (int)numChar);
-		{
-		kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-		kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg)+4);
-		kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-		}
-		return;
-		ASSERTNOTREACHED();
-		break;
-	case SC_Write:
-		DEBUG(dbgSys, "exception SC_Write begin \n");
-		val = kernel->machine->ReadRegister(4);
-		buf = &(kernel->machine->mainMemory[val]);		
-		numChar = SysWrite(buf, kernel->machine->ReadRegister(5), kernel->machine->ReadRegister(6));
-		kernel->machine->WriteRegister(2, (int)numChar);
-		{
-		kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-		kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg)+4);
-		kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-		}
-		DEBUG(dbgSys, "exception SC_Write end \n");
-		return;
-		ASSERTNOTREACHED();
-		break;
-		//finish read/write at 10.21 2:27
-/*
-	case SC_CloseFile:
-		int result = SysClose(kernel->machine->ReadRegister(4));
-		kernel->machine->WriteRegister(2, (int)result);
-		{
-		kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-		kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCreg)+4);
-		kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-		} 
-		return;
-		ASSERTNOTREACHED();
-		break;
-		//finish closefile but not sure close and closefile
-*/
-	case SC_Exit:
-		DEBUG(dbgAddr, "Program exit\n");
-            	val=kernel->machine->ReadRegister(4);
-            	cout << "return value:" << val << endl;
-		kernel->currentThread->Finish();
-	case SC_Close:
-            	val=kernel->machine->ReadRegister(4);
-		status = SysClose(val);
-		kernel->machine->WriteRegister(2, status);
-		{
-                kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-                kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg)+4);
-                kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-                }           	
-		return;
-		ASSERTNOTREACHED();
-           	break;
-      	default:
-		cerr << "Unexpected system call " << type << "\n";
-	    	break;
-	}
+	DoSyscall(type);
+	return;
+    case PageFaultException:
+	val = kernel->machine->ReadRegister(BadVAddrReg);
+	kernel->stats->numPageFaults++;
+	if (kernel->currentThread->space->PageFault(val))
+	    return;		// the access is retried
+	cerr << "Access to unmapped address " << val << "\n";
+	break;
+    case ReadOnlyException:
+	val = kernel->machine->ReadRegister(BadVAddrReg);
+	if (kernel->currentThread->space->CopyOnWrite(val))
+	    return;		// the write is retried
+	cerr << "Write to read-only address " << val << "\n";
+	break;
+    default:
+	cerr << "Unexpected user mode exception " << (int)which << "\n";
 	break;
-	default:
-		cerr << "Unexpected user mode exception " << (int)which << "\n";
-		break;
     }
     ASSERTNOTREACHED();
 }
-
@@ -12,6 +12,7 @@
 #define __USERPROG_KSYSCALL_H__ 
 
 #include "kernel.h"
+#include "proctable.h"
 
 #include "synchconsole.h"
 
@@ -28,6 +29,56 @@ void SysPrintInt(int val)
   DEBUG(dbgTraCode, "In ksyscall.h:SysPrintInt, return from synchConsoleOut->PutInt, " << kernel->stats->totalTicks);
 }
 
+SpaceId SysExec(char *name)
+{
+  return kernel->Exec(name, kernel->currentThread->basePriority);
+}
+
+SpaceId SysExecV(int argc, char **argv)
+{
+  return kernel->Exec(argv[0], kernel->currentThread->basePriority,
+		      argc, argv);
+}
+
+int SysJoin(SpaceId id)
+{
+  return kernel->processes->Join(id, kernel->currentThread->space->pid);
+}
+
+void SysExit(int status)
+{
+  AddrSpace *space = kernel->currentThread->space;
+
+  if (space->pid > 0)
+    kernel->processes->Exit(space->pid, status);
+  space->ExitThread(status);
+}
+
+ThreadId SysThreadFork(int func)
+{
+  return kernel->currentThread->space->ForkThread(func);
+}
+
+void SysThreadYield()
+{
+  kernel->currentThread->Yield();
+}
+
+int SysThreadJoin(ThreadId id)
+{
+  return kernel->currentThread->space->JoinThread(id);
+}
+
+void SysThreadExit(int exitCode)
+{
+  kernel->currentThread->space->ExitThread(exitCode);
+}
+
+void SysSleep(int ticks)
+{
+  kernel->alarm->WaitUntil(ticks);
+}
+
 int SysAdd(int op1, int op2)
 {
   return op1 + op2;
@@ -50,14 +101,25 @@ OpenFileId SysOpen(char *name)
 
 int SysWrite(char *buffer, int size, OpenFileId id)
 {
+	if (id == SysConsoleOutput) {
+		kernel->synchConsoleOut->PutBuffer(buffer, size);
+		return size;
+	}
 	return kernel->fileSystem->WriteFile(buffer, size, id);	
 }
 
 int SysRead(char *buffer, int size, OpenFileId id)
 {
+	if (id == SysConsoleInput)
+		return kernel->synchConsoleIn->Read(buffer, size);
 	return kernel->fileSystem->ReadFile(buffer, size, id);
 }
 
+int SysReadLine(char *buffer, int size)
+{
+	return kernel->synchConsoleIn->ReadLine(buffer, size);
+}
+
 int SysClose(OpenFileId id)
 {
 	return kernel->fileSystem->CloseFile(id);
@@ -0,0 +1,149 @@
+// pagecache.cc
+//	Routines to manage the cache of executable pages.  See
+//	pagecache.h.
+//
+//	The frames themselves are managed by AddrSpace (AllocFrame,
+//	RefFrame, FreeFrame); the cache is just one more holder of a
+//	reference.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "pagecache.h"
+#include "addrspace.h"
+#include "copyright.h"
+#include "debug.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// PageKey, PageHash
+//	The hash table key of a cached page, and the hash function.
+//----------------------------------------------------------------------
+
+static long long PageKey(int file, int page) {
+  return ((long long)file << 32) | (unsigned int)page;
+}
+
+static long long CachedPageKey(CachedPage *p) { return PageKey(p->file, p->page); }
+
+static unsigned PageHash(long long key) {
+  return (unsigned)(key >> 32) * 31 + (unsigned)key;
+}
+
+CachedPage::CachedPage(int fileId, int pageNum, int frameNum) {
+  file = fileId;
+  page = pageNum;
+  frame = frameNum;
+}
+
+//----------------------------------------------------------------------
+// PageCache::PageCache
+// 	Initialize an empty cache.
+//----------------------------------------------------------------------
+
+PageCache::PageCache() {
+  table = new HashTable<long long, CachedPage *>(CachedPageKey, PageHash);
+  order = new List<CachedPage *>;
+}
+
+PageCache::~PageCache() {
+  while (!order->IsEmpty()) {
+    delete order->RemoveFront();
+  }
+  delete order;
+  delete table;
+}
+
+//----------------------------------------------------------------------
+// PageCache::Lookup
+// 	Return the frame holding page "page" of executable "file", or -1
+//	if it is not cached.  The caller maps it with RefFrame.
+//----------------------------------------------------------------------
+
+int PageCache::Lookup(int file, int page) {
+  CachedPage *p;
+
+  if (!table->Find(PageKey(file, page), &p)) {
+    kernel->stats->numPageCacheMisses++;
+    return -1;
+  }
+  kernel->stats->numPageCacheHits++;
+  return p->frame;
+}
+
+//----------------------------------------------------------------------
+// PageCache::IsCached
+// 	Is page "page" of "file" cached?  Unlike Lookup, this is not
+//	counted as a hit or miss.
+//----------------------------------------------------------------------
+
+bool PageCache::IsCached(int file, int page) {
+  return table->IsInTable(PageKey(file, page));
+}
+
+//----------------------------------------------------------------------
+// PageCache::Insert
+// 	Record that "frame" holds page "page" of "file", freshly read.
+//	The caller's reference on the frame becomes the cache's.
+//----------------------------------------------------------------------
+
+void PageCache::Insert(int file, int page, int frame) {
+  CachedPage *p = new CachedPage(file, page, frame);
+
+  DEBUG(dbgAddr, "Caching page " << page << " of file " << file
+                                 << " in frame " << frame);
+  table->Insert(p);
+  order->Append(p);
+}
+
+//----------------------------------------------------------------------
+// PageCache::Evict
+// 	Free the frame of the oldest cached page that no address space
+//	maps.  Return FALSE if there is none.
+//----------------------------------------------------------------------
+
+bool PageCache::Evict() {
+  ListIterator<CachedPage *> iter(order);
+
+  for (; !iter.IsDone(); iter.Next()) {
+    CachedPage *p = iter.Item();
+
+    if (AddrSpace::frameRefs[p->frame] == 1) { // only ours
+      DEBUG(dbgAddr, "Evicting page " << p->page << " of file " << p->file
+                                      << " from frame " << p->frame);
+      order->Remove(p);
+      table->Remove(CachedPageKey(p));
+      AddrSpace::FreeFrame(p->frame);
+      delete p;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+//----------------------------------------------------------------------
+// PageCache::Invalidate
+// 	Forget every page of "file": it was written to or removed (and
+//	its header sector may be reused).  Address spaces that map those
+//	pages keep the old contents.
+//----------------------------------------------------------------------
+
+void PageCache::Invalidate(int file) {
+  List<CachedPage *> stale;
+  ListIterator<CachedPage *> iter(order);
+
+  for (; !iter.IsDone(); iter.Next()) {
+    if (iter.Item()->file == file) {
+      stale.Append(iter.Item());
+    }
+  }
+  while (!stale.IsEmpty()) {
+    CachedPage *p = stale.RemoveFront();
+
+    order->Remove(p);
+    table->Remove(CachedPageKey(p));
+    AddrSpace::FreeFrame(p->frame);
+    delete p;
+  }
+}
@@ -0,0 +1,59 @@
+// pagecache.h
+//	Data structures for the kernel's cache of executable pages.
+//
+//	The pages of a program holding code and initialized data are
+//	read from its file once, into frames that every process running
+//	the program maps read-only (copy-on-write, see addrspace.h).
+//	Pages are found by (file, page index); the file is named by the
+//	sector of its header, which stays the same as long as the file
+//	exists.  (With the stub file system, by the host file's inode.)
+//
+//	The cache holds a reference on each frame it caches, so the page
+//	outlives the processes that use it: running the program again
+//	later costs no I/O either.  A page that no process maps any more
+//	is only reclaimed when memory runs out (Evict), least recently
+//	loaded first.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGECACHE_H
+#define PAGECACHE_H
+
+#include "copyright.h"
+#include "hash.h"
+#include "list.h"
+
+// The following class records one cached page.
+
+class CachedPage {
+public:
+  CachedPage(int fileId, int pageNum, int frameNum);
+
+  int file;  // header sector of the executable
+  int page;  // page index within it
+  int frame; // where it is
+};
+
+// The following class defines the page cache.
+
+class PageCache {
+public:
+  PageCache();  // initialize an empty cache
+  ~PageCache(); // de-allocate the cache; the frames stay as they are
+
+  int Lookup(int file, int page); // frame holding the page, or -1
+  bool IsCached(int file, int page); // same, but just asking
+  void Insert(int file, int page, int frame);
+  // the frame now holds the page; the cache takes a reference on it
+  bool Evict();             // free a frame nobody else maps; FALSE if
+                            // every cached page is in use
+  void Invalidate(int file); // the file changed: forget its pages
+
+private:
+  HashTable<long long, CachedPage *> *table; // by file and page
+  List<CachedPage *> *order;           // oldest first, for Evict
+};
+
+#endif // PAGECACHE_H
@@ -0,0 +1,133 @@
+// pageprofile.cc
+//	Routines to profile the paging behaviour of an address space.
+//	See pageprofile.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "pageprofile.h"
+#include "copyright.h"
+#include "debug.h"
+#include "main.h"
+
+static const int HeatmapWidth = 64; // pages per line of the heatmap
+
+//----------------------------------------------------------------------
+// PageProfile::PageProfile
+// 	Start an empty profile of a space of "numPages" pages.
+//----------------------------------------------------------------------
+
+PageProfile::PageProfile(int pages) {
+  numPages = pages;
+  for (int i = 0; i <= CowFault; i++) {
+    faults[i] = 0;
+  }
+  faulted = new bool[numPages];
+  samplesUsed = new int[numPages];
+  written = new bool[numPages];
+  for (int i = 0; i < numPages; i++) {
+    faulted[i] = FALSE;
+    samplesUsed[i] = 0;
+    written[i] = FALSE;
+  }
+  numSamples = minSet = maxSet = totalSet = 0;
+}
+
+PageProfile::~PageProfile() {
+  delete[] faulted;
+  delete[] samplesUsed;
+  delete[] written;
+}
+
+//----------------------------------------------------------------------
+// PageProfile::Fault, PageProfile::CopyOnWrite
+// 	Count a fault on page "vpn".
+//----------------------------------------------------------------------
+
+void PageProfile::Fault(int vpn) {
+  ASSERT(vpn >= 0 && vpn < numPages);
+  faults[faulted[vpn] ? CapacityFault : ColdFault]++;
+  faulted[vpn] = TRUE;
+}
+
+void PageProfile::CopyOnWrite(int vpn) {
+  ASSERT(vpn >= 0 && vpn < numPages);
+  faults[CowFault]++;
+}
+
+//----------------------------------------------------------------------
+// PageProfile::Sample
+// 	Take a sample of the working set of process "pid": the pages
+//	whose use bit is set in "pageTable".  The use bits are cleared,
+//	so that the next sample only sees the pages used after this one.
+//----------------------------------------------------------------------
+
+void PageProfile::Sample(int pid, TranslationEntry *pageTable) {
+  int size = 0;
+
+  for (int i = 0; i < numPages; i++) {
+    if (pageTable[i].valid && pageTable[i].use) {
+      size++;
+      samplesUsed[i]++;
+      pageTable[i].use = FALSE;
+    }
+    if (pageTable[i].valid && pageTable[i].dirty) {
+      written[i] = TRUE;
+    }
+  }
+  if (numSamples == 0 || size < minSet) {
+    minSet = size;
+  }
+  if (size > maxSet) {
+    maxSet = size;
+  }
+  totalSet += size;
+  numSamples++;
+  DEBUG(dbgProfile, "Working set of process " << pid << " at tick "
+                    << kernel->stats->totalTicks << ": " << size
+                    << " pages");
+}
+
+//----------------------------------------------------------------------
+// PageProfile::Print
+// 	Print the profile of process "pid".  In the heatmap, each page
+//	is a digit from 1 to 9, scaled to the busiest page, by how many
+//	samples it was used in; '.' if none, and 'w' marks the pages
+//	that were written but never seen in a sample.
+//----------------------------------------------------------------------
+
+void PageProfile::Print(int pid) {
+  int hottest = 1;
+  int numWritten = 0;
+
+  for (int i = 0; i < numPages; i++) {
+    if (samplesUsed[i] > hottest) {
+      hottest = samplesUsed[i];
+    }
+    if (written[i]) {
+      numWritten++;
+    }
+  }
+  cout << "Page profile of process " << pid << ", " << numPages
+       << " pages:\n";
+  cout << "Faults: cold " << faults[ColdFault] << ", capacity "
+       << faults[CapacityFault] << ", copy-on-write " << faults[CowFault]
+       << "\n";
+  cout << "Working set: " << numSamples << " samples";
+  if (numSamples > 0) {
+    cout << ", min " << minSet << ", mean " << totalSet / numSamples
+         << ", max " << maxSet;
+  }
+  cout << " pages; " << numWritten << " pages written\n";
+  for (int i = 0; i < numPages; i++) {
+    if (samplesUsed[i] > 0) {
+      cout << (char)('1' + (samplesUsed[i] - 1) * 9 / hottest);
+    } else {
+      cout << (written[i] ? 'w' : '.');
+    }
+    if (i % HeatmapWidth == HeatmapWidth - 1 || i == numPages - 1) {
+      cout << "\n";
+    }
+  }
+}
@@ -0,0 +1,53 @@
+// pageprofile.h
+//	Data structures to profile how a user program uses its address
+//	space, to size physical memory and the replacement policies for
+//	a workload.
+//
+//	Faults are split into cold ones (the first on a page), capacity
+//	ones (the page was mapped before, but got pushed out of the TLB
+//	or memory) and copy-on-write ones.  The working set is sampled
+//	on each timer interrupt, from the use bits, which are cleared
+//	for the next interval; how often each page was in it makes the
+//	heatmap printed when the space goes away.
+//
+//	A space only has a profile when the 'p' debug flag is on, so
+//	that otherwise none of this costs anything.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGEPROFILE_H
+#define PAGEPROFILE_H
+
+#include "copyright.h"
+#include "translate.h"
+
+enum FaultKind { ColdFault, CapacityFault, CowFault };
+
+// The following class defines the profile of one address space.
+
+class PageProfile {
+public:
+  PageProfile(int numPages);  // start an empty profile
+  ~PageProfile();             // de-allocate it
+
+  void Fault(int vpn);        // page "vpn" was not mapped (by the TLB)
+  void CopyOnWrite(int vpn);  // page "vpn" got a private copy
+  void Sample(int pid, TranslationEntry *pageTable);
+  // record the pages used since the last sample, and clear their
+  // use bits
+  void Print(int pid);        // print the profile
+
+private:
+  int numPages;
+  int faults[CowFault + 1]; // by FaultKind
+  bool *faulted;            // per page: was it ever faulted in?
+  int *samplesUsed;         // per page: samples it was used in
+  bool *written;            // per page: ever dirtied?
+  int numSamples;           // working set samples taken
+  int minSet, maxSet;       // the smallest and largest of them
+  int totalSet;             // and their sum, for the mean
+};
+
+#endif // PAGEPROFILE_H
@@ -0,0 +1,144 @@
+// proctable.cc
+//	Routines to keep track of processes, for Exec and Join.
+//
+//	SpaceId 0 is never handed out, so that it can't be confused with
+//	a failed Exec by a user program that only checks for zero.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "proctable.h"
+#include "copyright.h"
+#include "debug.h"
+#include "main.h"
+#include "synch.h"
+
+//----------------------------------------------------------------------
+// ProcessTable::ProcessTable
+// 	Initialize an empty process table.
+//----------------------------------------------------------------------
+
+ProcessTable::ProcessTable() {
+  for (int i = 0; i < MaxProcesses; i++) {
+    table[i].inUse = FALSE;
+    table[i].done = NULL;
+  }
+}
+
+ProcessTable::~ProcessTable() {
+  for (int i = 0; i < MaxProcesses; i++) {
+    delete table[i].done;
+  }
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Add
+// 	Enter a new, running process, started by process "parent" (0
+//	for the kernel).  Return its SpaceId, or -1 if there is no free
+//	entry.
+//----------------------------------------------------------------------
+
+int ProcessTable::Add(int parent) {
+  IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+  int id;
+
+  for (id = 1; id < MaxProcesses; id++) {
+    if (!table[id].inUse) {
+      break;
+    }
+  }
+  if (id == MaxProcesses) {
+    (void)kernel->interrupt->SetLevel(oldLevel);
+    return -1;
+  }
+  table[id].inUse = TRUE;
+  table[id].exited = FALSE;
+  table[id].gone = FALSE;
+  table[id].joined = FALSE;
+  table[id].parent = parent;
+  // a fresh one: if nobody joined the last process in this entry,
+  // the old one was left signalled
+  delete table[id].done;
+  table[id].done = new Semaphore("process done", 0);
+  (void)kernel->interrupt->SetLevel(oldLevel);
+  DEBUG(dbgAddr, "New process " << id << ", parent " << parent);
+  return id;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Exit
+// 	Record that process "id" exited with "status", and wake up
+//	whoever is joining it.  Only the first Exit of a process counts.
+//----------------------------------------------------------------------
+
+void ProcessTable::Exit(int id, int status) {
+  ASSERT(id > 0 && id < MaxProcesses && table[id].inUse);
+  if (table[id].exited) {
+    return;
+  }
+  DEBUG(dbgAddr, "Process " << id << " exits with " << status);
+  table[id].exited = TRUE;
+  table[id].status = status;
+  table[id].done->V();
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Release
+// 	Record that the address space of process "id" has been deleted:
+//	its last thread is gone, with or without calling Exit.  Its
+//	children can't be joined any more, so those that are gone too
+//	are forgotten; so is "id" itself, if nobody can join it.
+//----------------------------------------------------------------------
+
+void ProcessTable::Release(int id) {
+  IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+  ASSERT(id > 0 && id < MaxProcesses && table[id].inUse);
+  Exit(id, -1); // if it never called Exit
+  table[id].gone = TRUE;
+  for (int i = 1; i < MaxProcesses; i++) {
+    if (table[i].inUse && table[i].parent == id) {
+      table[i].parent = 0;
+      Reap(i);
+    }
+  }
+  Reap(id);
+  (void)kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Reap
+// 	Free the entry of process "id" if it is gone and nobody can
+//	join it any more: its parent is gone too, or has joined it.
+//	(While its parent waits in Join, the entry has to stay.)
+//----------------------------------------------------------------------
+
+void ProcessTable::Reap(int id) {
+  if (table[id].gone && table[id].parent == 0) {
+    DEBUG(dbgAddr, "Process " << id << " reaped");
+    table[id].inUse = FALSE;
+  }
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Join
+// 	Wait for process "id" to exit, and return its exit status, or
+//	-1 if there is no such process or "parent" did not start it.
+//	Only its parent may join a process, and only once.
+//----------------------------------------------------------------------
+
+int ProcessTable::Join(int id, int parent) {
+  int status;
+
+  if (id <= 0 || id >= MaxProcesses || !table[id].inUse ||
+      parent == 0 || table[id].parent != parent || table[id].joined) {
+    return -1;
+  }
+  table[id].joined = TRUE;
+  table[id].done->P();
+  status = table[id].status;
+  table[id].parent = 0; // done with it
+  Reap(id);
+  return status;
+}
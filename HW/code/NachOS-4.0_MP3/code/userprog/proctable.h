@@ -0,0 +1,60 @@
+// proctable.h
+//	Data structures to keep track of the user programs (processes)
+//	started by Exec, so that another program can Join them.
+//
+//	A process is an address space, named by a SpaceId.  Only the
+//	process that started it may join it, so its entry stays in the
+//	table after it exits, holding the exit status, until it is
+//	joined or its parent is gone as well.  Processes started by the
+//	kernel itself (-e) have no parent: they are forgotten once gone.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROCTABLE_H
+#define PROCTABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+const int MaxProcesses = 32; // processes that have not been joined
+
+class Semaphore;
+
+// The following class records one process.
+
+class Process {
+public:
+  bool inUse;      // is this entry taken?
+  bool exited;     // has the process called Exit?
+  int status;      // if so, with what
+  bool gone;       // has its address space been deleted?
+  int parent;      // SpaceId of the process that may join it, or 0
+  bool joined;     // has it started to?
+  Semaphore *done; // signalled on Exit, for Join
+};
+
+// The following class defines the table of processes.
+
+class ProcessTable {
+public:
+  ProcessTable();  // initialize an empty table
+  ~ProcessTable(); // de-allocate the table
+
+  int Add(int parent);            // enter a new process, started by
+                                  // "parent"; return its SpaceId, or
+                                  // -1 if the table is full
+  void Exit(int id, int status);  // process "id" is done
+  void Release(int id);           // and its address space is gone
+  int Join(int id, int parent);   // wait for process "id", started by
+                                  // "parent", to exit, and return its
+                                  // status, or -1
+
+private:
+  void Reap(int id); // free the entry once nobody can join it
+
+  Process table[MaxProcesses];
+};
+
+#endif // PROCTABLE_H
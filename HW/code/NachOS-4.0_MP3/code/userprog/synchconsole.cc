@@ -22,6 +22,9 @@ SynchConsoleInput::SynchConsoleInput(char *inputFile)
     consoleInput = new ConsoleInput(inputFile, this);
     lock = new Lock("console in");
     waitFor = new Semaphore("console in", 0);
+    waiting = FALSE;
+    head = count = 0;
+    atEnd = FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -39,6 +42,7 @@ SynchConsoleInput::~SynchConsoleInput()
 //----------------------------------------------------------------------
 // SynchConsoleInput::GetChar
 //      Read a character typed at the keyboard, waiting if necessary.
+//	Return EOF at the end of the input.
 //----------------------------------------------------------------------
 
 char
@@ -46,23 +50,139 @@ SynchConsoleInput::GetChar()
 {
     char ch;
 
+    if (Read(&ch, 1) == 0)
+	return EOF;
+    return ch;
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleInput::Read
+//      Read up to "n" characters typed at the keyboard into "buf",
+//	as many as have arrived, waiting only if there are none yet.
+//	Return how many, 0 at the end of the input.
+//----------------------------------------------------------------------
+
+int
+SynchConsoleInput::Read(char *buf, int n)
+{
+    int done = 0;
+
     lock->Acquire();
-    waitFor->P();	// wait for EOF or a char to be available.
-    ch = consoleInput->GetChar();
+    if (n > 0 && WaitForInput()) {
+	IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+	while (done < n && count > 0) {
+	    int chunk = min(n - done, min(count, ConsoleBufferSize - head));
+
+	    bcopy(&ring[head], &buf[done], chunk);
+	    head = (head + chunk) % ConsoleBufferSize;
+	    count -= chunk;
+	    done += chunk;
+	}
+	Fill();				// the keyboard may have more
+	(void) kernel->interrupt->SetLevel(oldLevel);
+    }
     lock->Release();
-    return ch;
+    return done;
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleInput::ReadLine
+//      Read characters typed at the keyboard into "buf" up to and
+//	including a newline, or until there are "n" of them, waiting
+//	for them as necessary.  Return how many, fewer only at the end
+//	of the input.
+//----------------------------------------------------------------------
+
+int
+SynchConsoleInput::ReadLine(char *buf, int n)
+{
+    int done = 0;
+
+    lock->Acquire();
+    while (done < n && WaitForInput()) {
+	IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+	bool newline = FALSE;
+
+	while (done < n && count > 0 && !newline) {
+	    int chunk = min(n - done, min(count, ConsoleBufferSize - head));
+	    char *end = (char *) memchr(&ring[head], '\n', chunk);
+
+	    if (end != NULL) {
+		chunk = end - &ring[head] + 1;
+		newline = TRUE;
+	    }
+	    bcopy(&ring[head], &buf[done], chunk);
+	    head = (head + chunk) % ConsoleBufferSize;
+	    count -= chunk;
+	    done += chunk;
+	}
+	Fill();
+	(void) kernel->interrupt->SetLevel(oldLevel);
+	if (newline)
+	    break;
+    }
+    lock->Release();
+    return done;
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleInput::WaitForInput
+//      Wait until there is something in the ring buffer.  Return
+//	FALSE if there never will be.  Called with the lock held.
+//----------------------------------------------------------------------
+
+bool
+SynchConsoleInput::WaitForInput()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    while (count == 0 && !atEnd) {
+	waiting = TRUE;
+	waitFor->P();	// wait for EOF or a char to be available.
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    return count > 0;
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleInput::Fill
+//      Move whatever the keyboard has read into the ring buffer, as
+//	far as there is room.  (What doesn't fit stays in the keyboard,
+//	which doesn't look for more until it is taken.)  Interrupts
+//	are off.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleInput::Fill()
+{
+    while (count < ConsoleBufferSize) {
+	int tail = (head + count) % ConsoleBufferSize;
+	int room = min(ConsoleBufferSize - count, ConsoleBufferSize - tail);
+	int n = consoleInput->GetBuffer(&ring[tail], room);
+
+	if (n < 0)
+	    atEnd = TRUE;
+	if (n <= 0)
+	    break;
+	count += n;
+    }
 }
 
 //----------------------------------------------------------------------
 // SynchConsoleInput::CallBack
-//      Interrupt handler called when keystroke is hit; wake up
-//	anyone waiting.
+//      Interrupt handler called when keystrokes arrive; take them,
+//	and wake up anyone waiting.
 //----------------------------------------------------------------------
 
 void
 SynchConsoleInput::CallBack()
 {
-    waitFor->V();
+    Fill();
+    if (waiting) {
+	waiting = FALSE;
+	waitFor->V();
+    }
 }
 
 //----------------------------------------------------------------------
@@ -78,6 +198,9 @@ SynchConsoleOutput::SynchConsoleOutput(char *outputFile)
     consoleOutput = new ConsoleOutput(outputFile, this);
     lock = new Lock("console out");
     waitFor = new Semaphore("console out", 0);
+    waiting = FALSE;
+    head = count = 0;
+    busy = FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -87,6 +210,13 @@ SynchConsoleOutput::SynchConsoleOutput(char *outputFile)
 
 SynchConsoleOutput::~SynchConsoleOutput()
 { 
+    while (count > 0) {			// still queued: write it out now
+	int n = min(count, ConsoleBufferSize - head);
+
+	consoleOutput->Flush(&ring[head], n);
+	head = (head + n) % ConsoleBufferSize;
+	count -= n;
+    }
     delete consoleOutput; 
     delete lock; 
     delete waitFor;
@@ -99,43 +229,114 @@ SynchConsoleOutput::~SynchConsoleOutput()
 
 void
 SynchConsoleOutput::PutChar(char ch)
+{
+    PutBuffer(&ch, 1);
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutBuffer
+//      Queue "n" characters for the console display, and start sending
+//	them if it is idle.  Return once they are all queued, waiting
+//	for the display to make room if the buffer fills up.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::PutBuffer(char *buf, int n)
 {
     lock->Acquire();
-    consoleOutput->PutChar(ch);
-    waitFor->P();
+    while (n > 0) {
+	IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+	int tail = (head + count) % ConsoleBufferSize;
+	int room = min(ConsoleBufferSize - count, ConsoleBufferSize - tail);
+	int chunk = min(n, room);
+
+	if (chunk == 0) {		// full: wait for CallBack
+	    waiting = TRUE;
+	    (void) kernel->interrupt->SetLevel(oldLevel);
+	    waitFor->P();
+	    continue;
+	}
+	bcopy(buf, &ring[tail], chunk);
+	count += chunk;
+	buf += chunk;
+	n -= chunk;
+	if (!busy)
+	    StartOutput();
+	(void) kernel->interrupt->SetLevel(oldLevel);
+    }
     lock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleOutput::Drain
+//      Write whatever is queued to the display right away, without
+//	waiting for its interrupts: before the kernel itself prints
+//	(cout), so that the output stays in order, and before Nachos
+//	halts, so that none of it comes after the statistics.  The
+//	transfer in progress, if any, was written when it started.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::Drain()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+    while (count > 0) {
+	int n = min(count, ConsoleBufferSize - head);
+
+	consoleOutput->Flush(&ring[head], n);
+	kernel->stats->numConsoleCharsWritten += n;
+	head = (head + n) % ConsoleBufferSize;
+	count -= n;
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::StartOutput
+//      Send the queued characters to the display, as one transfer (up
+//	to the end of the ring; the rest goes next time).  Interrupts
+//	are off.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::StartOutput()
+{
+    int n = min(count, ConsoleBufferSize - head);
+
+    consoleOutput->PutBuffer(&ring[head], n);
+    head = (head + n) % ConsoleBufferSize;
+    count -= n;
+    busy = TRUE;
+}
+
 void
 SynchConsoleOutput::PutInt(int value)
 {
     char str[15];
-    int idx=0;
     //sprintf(str, "%d\n\0", value);  the true one
     sprintf(str, "%d\n\0", value); //simply for trace code
-    lock->Acquire();
-    do{
-	DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, into consoleOutput->PutChar, " << kernel->stats->totalTicks);
-        consoleOutput->PutChar(str[idx]);
-	DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, return from consoleOutput->PutChar, " << kernel->stats->totalTicks);
-	idx++;
-		
-	DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, into waitFor->P(), " << kernel->stats->totalTicks);
-        waitFor->P();
-	DEBUG(dbgTraCode, "In SynchConsoleOutput::PutChar, return form  waitFor->P(), " << kernel->stats->totalTicks);
-    } while (str[idx] != '\0');
-    lock->Release();
+    DEBUG(dbgTraCode, "In SynchConsoleOutput::PutInt, into PutBuffer, " << kernel->stats->totalTicks);
+    PutBuffer(str, strlen(str));
+    DEBUG(dbgTraCode, "In SynchConsoleOutput::PutInt, return from PutBuffer, " << kernel->stats->totalTicks);
 }
 
 //----------------------------------------------------------------------
 // SynchConsoleOutput::CallBack
 //      Interrupt handler called when it's safe to send the next 
-//	character can be sent to the display.
+//	character can be sent to the display: send whatever was queued
+//	meanwhile, and wake up the writer if it is waiting for room.
 //----------------------------------------------------------------------
 
 void
 SynchConsoleOutput::CallBack()
 {
     DEBUG(dbgTraCode, "In SynchConsoleOutput::CallBack(), " << kernel->stats->totalTicks);
-    waitFor->V();
+    busy = FALSE;
+    if (count > 0)
+	StartOutput();
+    if (waiting) {
+	waiting = FALSE;
+	waitFor->V();
+    }
 }
@@ -19,6 +19,17 @@
 
 // The following two classes define synchronized input and output to
 // a console device
+//
+// Output is buffered: characters are queued in a ring buffer, and
+// whatever has piled up while the display was busy goes out as one
+// transfer, with one interrupt.  A writer only waits when the buffer
+// is full.
+//
+// So is input: each time the keyboard has something, everything it
+// has is moved into a ring buffer (read-ahead), and readers take as
+// much of it as they want at once.
+
+const int ConsoleBufferSize = 256;	// characters queued either way
 
 class SynchConsoleInput : public CallBackObj {
   public:
@@ -26,12 +37,26 @@ class SynchConsoleInput : public CallBackObj {
     ~SynchConsoleInput();		// Deallocate console device
 
     char GetChar();		// Read a character, waiting if necessary
+    int Read(char *buf, int n);	// Read what is there, up to "n"
+				// characters, waiting for at least one
+    int ReadLine(char *buf, int n); // Read up to the end of the line,
+				// or "n" characters, waiting for them
+				// Both return 0 at end of file
     
   private:
     ConsoleInput *consoleInput;	// the hardware keyboard
     Lock *lock;			// only one reader at a time
     Semaphore *waitFor;		// wait for callBack
+    bool waiting;		// is the reader waiting?
 
+    char ring[ConsoleBufferSize]; // characters typed but not yet read
+    int head;			// the oldest of them
+    int count;			// how many there are
+    bool atEnd;			// no more will come
+
+    void Fill();		// move input from the keyboard to "ring"
+    bool WaitForInput();	// wait until "ring" is not empty; FALSE
+				// at end of file
     void CallBack();		// called when a keystroke is available
 };
 
@@ -41,14 +66,24 @@ class SynchConsoleOutput : public CallBackObj {
     ~SynchConsoleOutput();
 
     void PutChar(char ch);	// Write a character, waiting if necessary
+    void PutBuffer(char *buf, int n); // Write "n" characters, waiting
+				// only for room in the buffer
+    void Drain();		// Write out everything queued, now
     
     void PutInt(int n);
    
   private:
     ConsoleOutput *consoleOutput;// the hardware display
     Lock *lock;			// only one writer at a time
-    Semaphore *waitFor;		// wait for callBack
+    Semaphore *waitFor;		// wait for room in the buffer
+    bool waiting;		// is the writer waiting for it?
+
+    char ring[ConsoleBufferSize]; // characters not yet sent
+    int head;			// the oldest of them
+    int count;			// how many there are
+    bool busy;			// is the display writing?
 
+    void StartOutput();		// send what is queued
     void CallBack();		// called when more data can be written
 };
 
@@ -35,6 +35,10 @@
 #define SC_ThreadExit   14
 #define SC_ThreadJoin   15
 #define SC_PrintInt     16
+#define SC_Sleep	17
+#define SC_ReadV	18
+#define SC_WriteV	19
+#define SC_ReadLine	20
 #define SC_Add		42
 #define SC_MSG		100
 #ifndef IN_ASM
@@ -140,6 +144,33 @@ int Write(char *buffer, int size, OpenFileId id);
  */
 int Read(char *buffer, int size, OpenFileId id);
 
+/* Read a line typed at the console into "buffer": up to and including
+ * the newline, or "size" characters if the line is longer.  Return the
+ * number of characters read, 0 at the end of the input.  (Read on
+ * SysConsoleInput returns whatever has been typed, up to "size".)
+ */
+int ReadLine(char *buffer, int size);
+
+/* One piece of a buffer for ReadV and WriteV: "len" bytes at "base".
+ */
+typedef struct {
+  char *base;
+  int len;
+} IoVec;
+
+/* Write the "count" pieces of "iov" (at most 16) to the open file, in
+ * order, as if they were one buffer passed to Write -- but with one
+ * system call and one file system operation for all of them.
+ * Return the number of bytes written, negative error code on failure.
+ */
+int WriteV(IoVec *iov, int count, OpenFileId id);
+
+/* Read from the open file into the "count" pieces of "iov" (at most
+ * 16), filling each before the next, as one Read into one buffer.
+ * Return the number of bytes read, negative error code on failure.
+ */
+int ReadV(IoVec *iov, int count, OpenFileId id);
+
 /* Set the seek position of the open file "id"
  * to the byte "position".
  */
@@ -158,7 +189,8 @@ int Close(OpenFileId id);
  */
 
 /* Fork a thread to run a procedure ("func") in the *same* address space 
- * as the current thread.
+ * as the current thread.  It gets a stack of its own; "func" must end
+ * with ThreadExit, as it has nowhere to return to.
  * Return a positive ThreadId on success, negative error code on failure
  */
 ThreadId ThreadFork(void (*func)());
@@ -179,6 +211,11 @@ int ThreadJoin(ThreadId id);
  */
 void ThreadExit(int ExitCode);	
 
+/* Block the current thread for (at least) "ticks" units of simulated
+ * time, without using the CPU meanwhile.
+ */
+void Sleep(int ticks);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */